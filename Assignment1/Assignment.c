@@ -9,29 +9,37 @@
 // DateAdd(date, n)
 // Return the date which is n days after date.
 //
+// Besides the interactive mode the program takes these commands:
+// bench [first last]    closed form against the year-by-year loops over years
+//                       first..last (default 1..100000)
+// table [n]             year/month lookup tables against the closed form for
+//                       several window sizes
+// batch [n]             check and time the columnar kernels of datebatch.h
+// bulk input [output [threads]]
+//                       evaluate a whole file of expressions with the
+//                       multithreaded processor of datestream.h
+// calendar from to holidays [weekmask]
+//                       answer business-day queries from stdin (a-b counts
+//                       business days, a+n moves n business days) with the
+//                       index of calendar.h; weekmask bit w marks weekday w
+//                       as a working day (default 0x3E, Monday to Friday)
+//
 // author: C. H. Chen
 // date: 2024/09/13
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
-const int Monthtable[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-char weekday[8][10] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
-char monthname[14][10] = {"\0", "January","February", "March", "April", "May", "June",
-                            "July", "August", "September", "October", "November", "December"};
-
-typedef struct{
-    int day, month, year;
-} date;
+#include "date.h"
+#include "datebatch.h"
+#include "datestream.h"
+#include "calendar.h"
 
-int IsLeapYear(const int year){
-    if  (year%4000 == 0)    return 0;
-    if  (year%400 == 0)     return 1;
-    if  (year%100 == 0)     return 0;
-    if  (year%4 == 0)       return 1;
-    return 0;
-}
-
-int DateToNumber(const date date){
+// The original year-by-year loops, kept as the reference for the benchmark.
+// Only valid from 1970 onwards.
+int DateToNumberLoop(const date date){
     int daycount = 0;
     for (int i = 1970; i < date.year; i++){
         daycount = daycount + 365;
@@ -40,14 +48,12 @@ int DateToNumber(const date date){
     for (int i = 1; i < date.month; i++){
          daycount = daycount + Monthtable[i];
     }
-    for (int i = 1; i < date.day; i++){
-         daycount = daycount + 1;
-    }
+    daycount = daycount + date.day - 1;
     if(date.month > 2 && IsLeapYear(date.year)) daycount = daycount + 1;
     return daycount;
 }
 
-date NumberToDate(const int datenumber){
+date NumberToDateLoop(const int datenumber){
     date date;
     int count = datenumber;
     date.year = 1970;
@@ -71,20 +77,310 @@ date NumberToDate(const int datenumber){
     return date;
 }
 
-int DateSub(const date date1, const date date2){
-    return DateToNumber(date2) - DateToNumber(date1);
+// Convert one date per year in [first, last] both ways with the closed-form
+// engine and with the loops, and report the time of each.
+int DateBenchmark(const int first, const int last){
+    clock_t start, end;
+    double cpu_time_used;
+    long long checksum = 0;
+    date d;
+
+    start = clock();
+    for (int y = first; y <= last; y++){
+        d.year = y; d.month = y % 12 + 1; d.day = y % 28 + 1;
+        date back = NumberToDate(DateToNumber(d));
+        checksum += back.day + back.month + back.year;
+    }
+    end = clock();
+    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
+    printf("Closed form : years %d..%d, cpu time %.6f (checksum %lld)\n", first, last, cpu_time_used, checksum);
+
+    checksum = 0;
+    start = clock();
+    for (int y = first; y <= last; y++){
+        d.year = y; d.month = y % 12 + 1; d.day = y % 28 + 1;
+        date back = NumberToDateLoop(DateToNumberLoop(d));
+        checksum += back.day + back.month + back.year;
+    }
+    end = clock();
+    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
+    printf("Year loops  : years %d..%d, cpu time %.6f (checksum %lld)\n", first, last, cpu_time_used, checksum);
+
+    // The loops only count forward from 1970, so compare from there on
+    // (sampled, the loops are slow enough already).
+    for (int y = (first > 1970) ? first : 1970; y <= last; y += 97){
+        d.year = y; d.month = y % 12 + 1; d.day = y % 28 + 1;
+        int n = DateToNumber(d);
+        date a = NumberToDate(n), b = NumberToDateLoop(n);
+        if (n != DateToNumberLoop(d) || a.year != b.year || a.month != b.month || a.day != b.day){
+            printf("Mismatch at %d/%d/%d\n", d.year, d.month, d.day);
+            return 1;
+        }
+    }
+    return 0;
 }
 
-int DayOfWeek(const date date){
-    // 1970/1/1 is Thursday -> 4
-    return (DateToNumber(date) + 4) % 7;
+// Run every batch kernel over n random dates, time it against a loop of the
+// scalar functions and check that both give the same answers.
+int DateBatchBenchmark(const int n){
+    if (n <= 0) return 0;
+    clock_t start, end;
+    int *y = (int*)malloc(n * sizeof(int)), *m = (int*)malloc(n * sizeof(int));
+    int *d = (int*)malloc(n * sizeof(int)), *k = (int*)malloc(n * sizeof(int));
+    int *num = (int*)malloc(n * sizeof(int)), *ref = (int*)malloc(n * sizeof(int));
+    int *oy = (int*)malloc(n * sizeof(int)), *om = (int*)malloc(n * sizeof(int));
+    int *od = (int*)malloc(n * sizeof(int));
+    if (!y || !m || !d || !k || !num || !ref || !oy || !om || !od){
+        perror("Unable to allocate batch arrays");
+        exit(EXIT_FAILURE);
+    }
+    // Touch every array once so page faults are not charged to the first kernel.
+    // (not with zeros, which the compiler may turn into a lazy calloc)
+    memset(num, -1, n * sizeof(int)); memset(ref, -1, n * sizeof(int));
+    memset(oy, -1, n * sizeof(int)); memset(om, -1, n * sizeof(int)); memset(od, -1, n * sizeof(int));
+    srand(n);
+    for (int i = 0; i < n; i++){
+        y[i] = rand() % 110000 - 10000;
+        m[i] = rand() % 12 + 1;
+        d[i] = rand() % (Monthtable[m[i]] + (m[i] == 2 && IsLeapYear(y[i]))) + 1;
+        k[i] = rand() % 2000001 - 1000000;
+    }
+    int error = 0;
+    double scalar_time, batch_time;
+
+    // DateToNumber
+    start = clock();
+    for (int i = 0; i < n; i++){ date t = {d[i], m[i], y[i]}; ref[i] = DateToNumber(t); }
+    end = clock();
+    scalar_time = ((double) (end - start)) / CLOCKS_PER_SEC;
+    start = clock();
+    DateToNumberBatch(n, y, m, d, num);
+    end = clock();
+    batch_time = ((double) (end - start)) / CLOCKS_PER_SEC;
+    for (int i = 0; i < n; i++) if (num[i] != ref[i]){ printf("DateToNumberBatch mismatch at %d\n", i); error = 1; break; }
+    printf("DateToNumber      scalar %.6f batch %.6f\n", scalar_time, batch_time);
+
+    // NumberToDate
+    start = clock();
+    for (int i = 0; i < n; i++){ date t = NumberToDate(ref[i]); y[i] = t.year; m[i] = t.month; d[i] = t.day; }
+    end = clock();
+    scalar_time = ((double) (end - start)) / CLOCKS_PER_SEC;
+    start = clock();
+    NumberToDateBatch(n, ref, oy, om, od);
+    end = clock();
+    batch_time = ((double) (end - start)) / CLOCKS_PER_SEC;
+    for (int i = 0; i < n; i++) if (oy[i] != y[i] || om[i] != m[i] || od[i] != d[i]){ printf("NumberToDateBatch mismatch at %d\n", i); error = 1; break; }
+    printf("NumberToDate      scalar %.6f batch %.6f\n", scalar_time, batch_time);
+
+    // DateAdd, compared through the day numbers of the results
+    start = clock();
+    for (int i = 0; i < n; i++){ date t = {d[i], m[i], y[i]}; t = DateAdd(t, k[i]); ref[i] = DateToNumber(t); }
+    end = clock();
+    scalar_time = ((double) (end - start)) / CLOCKS_PER_SEC;
+    start = clock();
+    DateAddBatch(n, y, m, d, k, oy, om, od);
+    end = clock();
+    batch_time = ((double) (end - start)) / CLOCKS_PER_SEC;
+    DateToNumberBatch(n, oy, om, od, num);
+    for (int i = 0; i < n; i++) if (num[i] != ref[i]){ printf("DateAddBatch mismatch at %d\n", i); error = 1; break; }
+    printf("DateAdd           scalar %.6f batch %.6f\n", scalar_time, batch_time);
+
+    // DayNumberAdd against the day numbers of DateAdd
+    DateToNumberBatch(n, y, m, d, oy);
+    DayNumberAddBatch(n, oy, k, num);
+    for (int i = 0; i < n; i++) if (num[i] != ref[i]){ printf("DayNumberAddBatch mismatch at %d\n", i); error = 1; break; }
+
+    // DayOfWeek
+    start = clock();
+    for (int i = 0; i < n; i++){ date t = {d[i], m[i], y[i]}; ref[i] = DayOfWeek(t); }
+    end = clock();
+    scalar_time = ((double) (end - start)) / CLOCKS_PER_SEC;
+    start = clock();
+    DayOfWeekBatch(n, y, m, d, num);
+    end = clock();
+    batch_time = ((double) (end - start)) / CLOCKS_PER_SEC;
+    for (int i = 0; i < n; i++) if (num[i] != ref[i]){ printf("DayOfWeekBatch mismatch at %d\n", i); error = 1; break; }
+    printf("DayOfWeek         scalar %.6f batch %.6f\n", scalar_time, batch_time);
+
+    free(y); free(m); free(d); free(k); free(num); free(ref); free(oy); free(om); free(od);
+    return error;
 }
 
-date DateAdd(const date date, const int n){
-    return NumberToDate(DateToNumber(date) + n);
+// Answer business-day queries read from stdin against the calendar of
+// [from, to] with the holidays listed in the given file.
+int CalendarQueries(const date from, const date to, const char *holidayfile, const int weekmask){
+    // Either order of the range, and of the two dates of a query, as in the
+    // interactive mode
+    int swap = DateToNumber(from) > DateToNumber(to);
+    FILE *fp = fopen(holidayfile, "r");
+    if (fp == NULL){
+        perror("Unable to open holiday file");
+        return 1;
+    }
+    calendar_t *cal = CalendarBuild(swap ? to : from, swap ? from : to, weekmask, fp);
+    fclose(fp);
+    if (cal == NULL) return 1;
+
+    date date1, date2;
+    char op, buf[30] = {'\0'};
+    int n, fields, expected;
+    while(scanf("%29s", buf) != EOF){
+        op = '!';
+        if (strchr(buf, '+')){
+            op = '+';
+            expected = 4;
+            fields = sscanf(buf, "%d/%d/%d+%d", &date1.year, &date1.month, &date1.day, &n);
+        }else if (strchr(buf, '-')){
+            op = '-';
+            expected = 6;
+            fields = sscanf(buf, "%d/%d/%d-%d/%d/%d", &date1.year, &date1.month, &date1.day,
+                    &date2.year, &date2.month, &date2.day);
+        }else{
+            expected = 3;
+            fields = sscanf(buf, "%d/%d/%d", &date1.year, &date1.month, &date1.day);
+        }
+        // A short parse would leave fields of the previous line, or none at all
+        if (fields != expected ||
+            date1.month < 1 || date1.month > 12 || (op == '-' && (date2.month < 1 || date2.month > 12))){
+            printf("Invalid input %s\n\n", buf);
+            continue;
+        }
+        switch (op){
+            case '+':
+                date2 = BusinessDayAdd(cal, date1, n);
+                printf("%d business days %s %s %d, %d is ", (n < 0) ? -n : n, (n < 0) ? "before" : "after",
+                        monthname[date1.month], date1.day, date1.year);
+                printf("%s %d, %d\n\n", monthname[date2.month], date2.day, date2.year);
+                break;
+            case '-':
+                if (DateToNumber(date1) > DateToNumber(date2)){
+                    date t = date1; date1 = date2; date2 = t;
+                }
+                printf("%d business days from %s %d, %d ", BusinessDaySub(cal, date1, date2),
+                        monthname[date1.month], date1.day, date1.year);
+                printf("to %s %d, %d\n\n", monthname[date2.month], date2.day, date2.year);
+                break;
+            default:
+                printf("%s %d, %d is %sa business day.\n\n", monthname[date1.month], date1.day, date1.year,
+                        IsBusinessDay(cal, date1) ? "" : "not ");
+                break;
+        }
+    }
+    CalendarFree(cal);
+    return 0;
+}
+
+// Time the table conversions of date.h against the closed form on n random
+// dates, for year windows of growing size around 2000.
+int DateTableBenchmark(const int n){
+    const int windows[6] = {10, 100, 800, 4000, 40000, 400000};
+    clock_t start, end;
+    date *dates = (date*)malloc(n * sizeof(date));
+    int *nums = (int*)malloc(n * sizeof(int));
+    if (dates == NULL || nums == NULL){
+        perror("Unable to allocate benchmark arrays");
+        exit(EXIT_FAILURE);
+    }
+    printf("%8s %10s %12s %12s %12s %12s\n", "years", "bytes", "closed d->n", "table d->n", "closed n->d", "table n->d");
+    for (int w = 0; w < 6; w++){
+        int first = 2000 - windows[w] / 2, last = first + windows[w] - 1;
+        int *storage = (int*)malloc((last - first + 2) * sizeof(int));
+        if (storage == NULL){
+            perror("Unable to allocate year table");
+            exit(EXIT_FAILURE);
+        }
+        datetable_t table;
+        DateTableFill(&table, first, last, storage);
+        srand(windows[w]);
+        for (int i = 0; i < n; i++){
+            dates[i].year = first + rand() % windows[w];
+            dates[i].month = rand() % 12 + 1;
+            dates[i].day = rand() % 28 + 1;
+            nums[i] = table.lo + rand() % (table.hi - table.lo + 1);
+        }
+        double t[4];
+        long long checksum[4] = {0};
+        start = clock();
+        for (int i = 0; i < n; i++) checksum[0] += DaysFromCivil(dates[i]);
+        end = clock();
+        t[0] = ((double) (end - start)) / CLOCKS_PER_SEC;
+        start = clock();
+        for (int i = 0; i < n; i++) checksum[1] += TableDateToNumber(&table, dates[i]);
+        end = clock();
+        t[1] = ((double) (end - start)) / CLOCKS_PER_SEC;
+        start = clock();
+        for (int i = 0; i < n; i++) checksum[2] += CivilFromDays(nums[i]).day;
+        end = clock();
+        t[2] = ((double) (end - start)) / CLOCKS_PER_SEC;
+        start = clock();
+        for (int i = 0; i < n; i++) checksum[3] += TableNumberToDate(&table, nums[i]).day;
+        end = clock();
+        t[3] = ((double) (end - start)) / CLOCKS_PER_SEC;
+        if (checksum[0] != checksum[1] || checksum[2] != checksum[3]){
+            printf("Table and closed form disagree for window %d..%d\n", first, last);
+            return 1;
+        }
+        printf("%8d %10zu %12.6f %12.6f %12.6f %12.6f\n", windows[w],
+                (last - first + 2) * sizeof(int) + sizeof(Monthoffset), t[0], t[1], t[2], t[3]);
+        free(storage);
+    }
+    free(dates);
+    free(nums);
+    return 0;
 }
 
-int main(void){
+int main(int argc, char *argv[]){
+    if (argc > 1 && strcmp(argv[1], "table") == 0){
+        int n = 10000000;
+        if (argc > 2) sscanf(argv[2], "%d", &n);
+        return DateTableBenchmark(n);
+    }
+    if (argc > 4 && strcmp(argv[1], "calendar") == 0){
+        date from, to;
+        int weekmask = 0x3E;
+        if (sscanf(argv[2], "%d/%d/%d", &from.year, &from.month, &from.day) != 3 ||
+            sscanf(argv[3], "%d/%d/%d", &to.year, &to.month, &to.day) != 3){
+            fprintf(stderr, "Calendar range must be given as yyyy/mm/dd yyyy/mm/dd\n");
+            return 1;
+        }
+        if (argc > 5) sscanf(argv[5], "%i", &weekmask);
+        return CalendarQueries(from, to, argv[4], weekmask);
+    }
+    if (argc > 2 && strcmp(argv[1], "bulk") == 0){
+        FILE *out = stdout;
+        int threads = sysconf(_SC_NPROCESSORS_ONLN);
+        if (argc > 3 && strcmp(argv[3], "-") != 0 && (out = fopen(argv[3], "w")) == NULL){
+            perror("Unable to open output");
+            return 1;
+        }
+        if (argc > 4) sscanf(argv[4], "%d", &threads);
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        long long count = DateStream(argv[2], out, threads);
+        if ((out != stdout) ? fclose(out) != 0 : fflush(out) != 0){
+            perror("Error writing output");
+            count = -1;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+        if (count >= 0)
+            fprintf(stderr, "%lld expressions in %.3f s (%.0f per second, %d threads)\n",
+                    count, seconds, count / seconds, threads);
+        return count < 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "batch") == 0){
+        int n = 10000000;
+        if (argc > 2) sscanf(argv[2], "%d", &n);
+        return DateBatchBenchmark(n);
+    }
+    if (argc > 1 && strcmp(argv[1], "bench") == 0){
+        int first = 1, last = 100000;
+        if (argc > 3){
+            sscanf(argv[2], "%d", &first);
+            sscanf(argv[3], "%d", &last);
+        }
+        return DateBenchmark(first, last);
+    }
     date date1, date2;
     char op, buf[30] = {'\0'};
     int n;
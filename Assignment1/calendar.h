@@ -0,0 +1,199 @@
+/* Business-day calendar over the date data type.
+
+   A calendar covers the day numbers [first, last]. A day is a business day if
+   its weekday is in the week mask (bit w set -> DayOfWeek w is a working day,
+   0x3E is Monday to Friday) and it is not listed as a holiday. The index keeps
+   one bit per day in 64-day blocks together with the number of business days
+   before each block, and the block of every 64th business day, about 2 bits
+   per day in total. Counting business days between two dates is then a rank
+   (prefix count + popcount) and finding the n-th business day is a select
+   (sample + in-block search), both in constant time.
+
+   Outside [first, last] only the week mask applies, so every query has an
+   answer. */
+
+#ifndef __CALENDAR_H__
+#define __CALENDAR_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "date.h"
+
+typedef struct calendar{
+    int first, last;    // covered day numbers
+    int blocks;         // number of 64-day blocks
+    int total;          // business days in [first, last]
+    uint64_t *bits;     // bit i of bits[b]: day first + 64*b + i is a business day
+    uint32_t *rank;     // business days before block b, rank[blocks] == total
+    uint32_t *sample;   // sample[j]: block holding business day 64*j
+    int weekmask;
+    int perweek;        // business weekdays per week
+    int weekrank[8];    // business days among the first r days of the week of day 0
+    int weekpos[7];     // position of the r-th business day in that week
+} calendar_t;
+
+// Free the dynamically allocated memory associated with a calendar.
+void CalendarFree(calendar_t *cal){
+    assert(cal != NULL);
+    free(cal->bits);
+    free(cal->rank);
+    free(cal->sample);
+    free(cal);
+}
+
+// Build the calendar for [from, to] with the given week mask. The holiday
+// stream (may be NULL) holds yyyy/mm/dd dates separated by white space;
+// holidays outside the range are ignored.
+calendar_t *CalendarBuild(const date from, const date to, const int weekmask, FILE *holidays){
+    int first = DateToNumber(from), last = DateToNumber(to);
+    if (first > last){
+        fprintf(stderr, "Calendar range is empty\n");
+        return NULL;
+    }
+    if ((weekmask & 0x7F) == 0){
+        fprintf(stderr, "Week mask has no business day\n");
+        return NULL;
+    }
+    calendar_t *cal = (calendar_t*)calloc(1, sizeof(calendar_t));
+    if (cal == NULL){
+        perror("Unable to allocate calendar");
+        exit(EXIT_FAILURE);
+    }
+    cal->first = first;
+    cal->last = last;
+    cal->weekmask = weekmask & 0x7F;
+    cal->blocks = (last - first) / 64 + 1;
+
+    // Week pattern, counted from day 0 (a Thursday)
+    cal->perweek = 0;
+    for (int r = 0; r < 7; r++){
+        cal->weekrank[r] = cal->perweek;
+        if (cal->weekmask >> ((4 + r) % 7) & 1)
+            cal->weekpos[cal->perweek++] = r;
+    }
+    cal->weekrank[7] = cal->perweek;
+
+    // One spare block so that the day after last can always be ranked
+    cal->bits = (uint64_t*)calloc(cal->blocks + 1, sizeof(uint64_t));
+    cal->rank = (uint32_t*)malloc((cal->blocks + 1) * sizeof(uint32_t));
+    if (cal->bits == NULL || cal->rank == NULL){
+        perror("Unable to allocate calendar");
+        exit(EXIT_FAILURE);
+    }
+    for (int x = first; x <= last; x++){
+        int w = (x + 4) % 7;
+        if (w < 0) w += 7;
+        if (cal->weekmask >> w & 1)
+            cal->bits[(x - first) >> 6] |= (uint64_t)1 << ((x - first) & 63);
+    }
+
+    if (holidays != NULL){
+        date d;
+        while (fscanf(holidays, "%d/%d/%d", &d.year, &d.month, &d.day) == 3){
+            int x = DateToNumber(d);
+            if (x >= first && x <= last)
+                cal->bits[(x - first) >> 6] &= ~((uint64_t)1 << ((x - first) & 63));
+        }
+        if (!feof(holidays)){
+            fprintf(stderr, "Error in holiday input: expected yyyy/mm/dd\n");
+            CalendarFree(cal);
+            return NULL;
+        }
+    }
+
+    uint32_t count = 0;
+    for (int b = 0; b <= cal->blocks; b++){
+        cal->rank[b] = count;
+        count += __builtin_popcountll(cal->bits[b]);
+    }
+    cal->total = count;
+
+    cal->sample = (uint32_t*)malloc(((count >> 6) + 2) * sizeof(uint32_t));
+    if (cal->sample == NULL){
+        perror("Unable to allocate calendar");
+        exit(EXIT_FAILURE);
+    }
+    int j = 0;
+    for (int b = 0; b < cal->blocks; b++){
+        while ((uint32_t)j << 6 < cal->rank[b + 1])
+            cal->sample[j++] = b;
+    }
+    for ( ; j <= (int)(count >> 6) + 1; j++)
+        cal->sample[j] = cal->blocks - 1;
+    return cal;
+}
+
+// Business days by week mask alone in [0, x) (negative for x < 0).
+static inline int CalendarWeekRank(const calendar_t *cal, const int x){
+    int weeks = FloorDiv(x, 7);
+    return weeks * cal->perweek + cal->weekrank[x - 7 * weeks];
+}
+
+// Day number of business day t by week mask alone, the inverse of CalendarWeekRank.
+static inline int CalendarWeekSelect(const calendar_t *cal, const int t){
+    int weeks = FloorDiv(t, cal->perweek);
+    return 7 * weeks + cal->weekpos[t - weeks * cal->perweek];
+}
+
+// Business days in [first, x), negative when x < first.
+int CalendarRank(const calendar_t *cal, const int x){
+    if (x <= cal->first)
+        return CalendarWeekRank(cal, x) - CalendarWeekRank(cal, cal->first);
+    if (x > cal->last + 1)
+        return cal->total + CalendarWeekRank(cal, x) - CalendarWeekRank(cal, cal->last + 1);
+    int i = x - cal->first;
+    uint64_t below = ((uint64_t)1 << (i & 63)) - 1;
+    return cal->rank[i >> 6] + __builtin_popcountll(cal->bits[i >> 6] & below);
+}
+
+// Position of the r-th set bit of w (r < popcount(w)).
+static inline int CalendarSelect64(uint64_t w, int r){
+    int base = 0, c;
+    while (r >= (c = __builtin_popcount((unsigned)(w & 0xFF)))){
+        r -= c;
+        w >>= 8;
+        base += 8;
+    }
+    while (r--) w &= w - 1;
+    return base + __builtin_ctzll(w);
+}
+
+// Day number of business day k, counted from 0 at the first one of the range
+// (negative k reaches back before the range).
+int CalendarSelect(const calendar_t *cal, const int k){
+    if (k < 0)
+        return CalendarWeekSelect(cal, CalendarWeekRank(cal, cal->first) + k);
+    if (k >= cal->total)
+        return CalendarWeekSelect(cal, CalendarWeekRank(cal, cal->last + 1) + k - cal->total);
+    // The block lies between two samples, which are almost always adjacent
+    int lo = cal->sample[k >> 6], hi = cal->sample[(k >> 6) + 1];
+    while (lo < hi){
+        int m = (lo + hi + 1) >> 1;
+        if (cal->rank[m] <= (uint32_t)k) lo = m; else hi = m - 1;
+    }
+    return cal->first + 64 * lo + CalendarSelect64(cal->bits[lo], k - cal->rank[lo]);
+}
+
+int IsBusinessDay(const calendar_t *cal, const date d){
+    int x = DateToNumber(d);
+    return CalendarRank(cal, x + 1) - CalendarRank(cal, x);
+}
+
+// Return number of business days from date1 (included) to date2 (excluded),
+// negative if date2 is before date1.
+int BusinessDaySub(const calendar_t *cal, const date date1, const date date2){
+    return CalendarRank(cal, DateToNumber(date2)) - CalendarRank(cal, DateToNumber(date1));
+}
+
+// Return the date which is n business days after date (before if n < 0).
+date BusinessDayAdd(const calendar_t *cal, const date d, const int n){
+    int x = DateToNumber(d);
+    if (n > 0) return NumberToDate(CalendarSelect(cal, CalendarRank(cal, x + 1) + n - 1));
+    if (n < 0) return NumberToDate(CalendarSelect(cal, CalendarRank(cal, x) + n));
+    return d;
+}
+
+#endif
@@ -0,0 +1,172 @@
+/* Date data type and the conversion between dates and day numbers (days since
+   1970/01/01): table lookups inside the window DATE_TABLE_FIRST..DATE_TABLE_LAST
+   and a closed form everywhere else. */
+
+#ifndef __DATE_H__
+#define __DATE_H__
+
+const int Monthtable[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+char weekday[8][10] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+char monthname[14][10] = {"\0", "January","February", "March", "April", "May", "June",
+                            "July", "August", "September", "October", "November", "December"};
+
+typedef struct{
+    int day, month, year;
+} date;
+
+int IsLeapYear(const int year){
+    if  (year%4000 == 0)    return 0;
+    if  (year%400 == 0)     return 1;
+    if  (year%100 == 0)     return 0;
+    if  (year%4 == 0)       return 1;
+    return 0;
+}
+
+// Floor division, so that dates before the epoch land in the right cycle.
+// Written without a branch so the batch kernels can vectorize it.
+static inline int FloorDiv(const int a, const int b){
+    return (a - ((a < 0) ? b - 1 : 0)) / b;
+}
+
+// Number of leap years in 1..year (negative for year < 0), following IsLeapYear.
+static inline int LeapYearsBefore(const int year){
+    return FloorDiv(year, 4) - FloorDiv(year, 100) + FloorDiv(year, 400) - FloorDiv(year, 4000);
+}
+
+// Days in one 4000-year cycle and in one 400-year era.
+#define DAYS_PER_CYCLE 1460969
+#define DAYS_PER_ERA 146097
+// Days from 0000/03/01 to 1970/01/01.
+#define EPOCH_SHIFT 719468
+
+// Closed-form days-from-civil. Years are counted from March so that the leap
+// day is the last day of the year and the month offsets are a linear formula.
+int DaysFromCivil(const date date){
+    int y = date.year - (date.month <= 2);
+    int mp = (date.month > 2) ? date.month - 3 : date.month + 9;
+    int doy = (153 * mp + 2) / 5 + date.day - 1;
+    return 365 * y + LeapYearsBefore(y) + doy - EPOCH_SHIFT;
+}
+
+// Closed-form civil-from-days. Inside a 4000-year cycle the first nine eras
+// have 146097 days and the last one 146096 (year%4000 is not leap).
+date CivilFromDays(const int datenumber){
+    date date;
+    int z = datenumber + EPOCH_SHIFT;
+    int cycle = FloorDiv(z, DAYS_PER_CYCLE);
+    int doc = z - cycle * DAYS_PER_CYCLE;
+    int era = doc / DAYS_PER_ERA;
+    int doe = doc - era * DAYS_PER_ERA;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    date.day = doy - (153 * mp + 2) / 5 + 1;
+    date.month = (mp < 10) ? mp + 3 : mp - 9;
+    date.year = yoe + era * 400 + cycle * 4000 + (date.month <= 2);
+    return date;
+}
+
+// Year window covered by the lookup tables, override with -DDATE_TABLE_FIRST=...
+#ifndef DATE_TABLE_FIRST
+#define DATE_TABLE_FIRST 1600
+#endif
+#ifndef DATE_TABLE_LAST
+#define DATE_TABLE_LAST 2400
+#endif
+
+// Days before the first of each month, for common and leap years.
+const short Monthoffset[2][14] = {
+    {0, 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365},
+    {0, 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366}};
+
+// Year table of a window [first, last]: year[i] holds twice the day number
+// of (first + i)/01/01 plus the leap flag. One extra entry closes the last year.
+typedef struct{
+    int first, last;
+    int lo, hi;     // day numbers covered
+    int *year;
+} datetable_t;
+
+// Day number and leap flag of a year entry, negative before 1970 as well.
+static inline int TableYearStart(const int y){
+    return (y - (y & 1)) / 2;
+}
+
+static inline int TableYearLeap(const int y){
+    return y & 1;
+}
+
+// Fill the table of [first, last] into storage of last - first + 2 ints.
+void DateTableFill(datetable_t *table, const int first, const int last, int *storage){
+    date jan1 = {1, 1, first};
+    int start = DaysFromCivil(jan1);
+    table->first = first;
+    table->last = last;
+    table->year = storage;
+    for (int y = first; y <= last + 1; y++){
+        int leap = IsLeapYear(y);
+        storage[y - first] = 2 * start + leap;
+        start += 365 + leap;
+    }
+    table->lo = TableYearStart(storage[0]);
+    table->hi = TableYearStart(storage[last - first + 1]) - 1;
+}
+
+// Table conversions, valid for dates inside the window only.
+static inline int TableDateToNumber(const datetable_t *table, const date date){
+    int y = table->year[date.year - table->first];
+    return TableYearStart(y) + Monthoffset[TableYearLeap(y)][date.month] + date.day - 1;
+}
+
+static inline date TableNumberToDate(const datetable_t *table, const int datenumber){
+    date date;
+    // The mean Gregorian year lands on the right year or next to it
+    int i = (int)(((long long)(datenumber - table->lo) * 400) / DAYS_PER_ERA);
+    if (i > table->last - table->first) i = table->last - table->first;
+    while (TableYearStart(table->year[i]) > datenumber) i--;
+    while (TableYearStart(table->year[i + 1]) <= datenumber) i++;
+    int y = table->year[i];
+    int doy = datenumber - TableYearStart(y);
+    int m = (doy >> 5) + 1;
+    if (doy >= Monthoffset[TableYearLeap(y)][m + 1]) m++;
+    date.year = table->first + i;
+    date.month = m;
+    date.day = doy - Monthoffset[TableYearLeap(y)][m] + 1;
+    return date;
+}
+
+// The window table, generated once when the program is loaded.
+int Yeartable[DATE_TABLE_LAST - DATE_TABLE_FIRST + 2];
+datetable_t Datetable;
+
+__attribute__((constructor)) static void DateTableInit(void){
+    DateTableFill(&Datetable, DATE_TABLE_FIRST, DATE_TABLE_LAST, Yeartable);
+}
+
+int DateToNumber(const date date){
+    if ((unsigned)(date.year - DATE_TABLE_FIRST) <= DATE_TABLE_LAST - DATE_TABLE_FIRST)
+        return TableDateToNumber(&Datetable, date);
+    return DaysFromCivil(date);
+}
+
+date NumberToDate(const int datenumber){
+    if ((unsigned)(datenumber - Datetable.lo) <= (unsigned)(Datetable.hi - Datetable.lo))
+        return TableNumberToDate(&Datetable, datenumber);
+    return CivilFromDays(datenumber);
+}
+
+int DateSub(const date date1, const date date2){
+    return DateToNumber(date2) - DateToNumber(date1);
+}
+
+int DayOfWeek(const date date){
+    // 1970/1/1 is Thursday -> 4
+    int w = (DateToNumber(date) + 4) % 7;
+    return (w < 0) ? w + 7 : w;
+}
+
+date DateAdd(const date date, const int n){
+    return NumberToDate(DateToNumber(date) + n);
+}
+
+#endif
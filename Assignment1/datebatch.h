@@ -0,0 +1,86 @@
+/* Batch date routines over columnar (structure-of-arrays) data.
+
+   Every routine walks n independent records stored as separate year, month,
+   day or day-number arrays. The loop bodies are the closed-form conversions of
+   date.h written with selects instead of branches and restrict pointers, so
+   that gcc/clang auto-vectorize them (compile with -O3 -mavx2 or -march=native,
+   -O3 alone gives SSE2). The output arrays must not overlap the inputs. */
+
+#ifndef __DATEBATCH_H__
+#define __DATEBATCH_H__
+
+#include "date.h"
+
+// num[i] = DateToNumber(year[i]/month[i]/day[i])
+void DateToNumberBatch(const int n, const int *restrict year, const int *restrict month,
+                       const int *restrict day, int *restrict num){
+    for (int i = 0; i < n; i++){
+        int march = month[i] > 2;
+        int y = year[i] - !march;
+        int mp = month[i] + (march ? -3 : 9);
+        int doy = (153 * mp + 2) / 5 + day[i] - 1;
+        num[i] = 365 * y + LeapYearsBefore(y) + doy - EPOCH_SHIFT;
+    }
+}
+
+// year[i]/month[i]/day[i] = NumberToDate(num[i])
+void NumberToDateBatch(const int n, const int *restrict num, int *restrict year,
+                       int *restrict month, int *restrict day){
+    for (int i = 0; i < n; i++){
+        int z = num[i] + EPOCH_SHIFT;
+        int cycle = FloorDiv(z, DAYS_PER_CYCLE);
+        int doc = z - cycle * DAYS_PER_CYCLE;
+        int era = doc / DAYS_PER_ERA;
+        int doe = doc - era * DAYS_PER_ERA;
+        int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        int mp = (5 * doy + 2) / 153;
+        int m = mp + ((mp < 10) ? 3 : -9);
+        day[i] = doy - (153 * mp + 2) / 5 + 1;
+        month[i] = m;
+        year[i] = yoe + era * 400 + cycle * 4000 + (m <= 2);
+    }
+}
+
+// Day-number form of DateAdd: out[i] = num[i] + offset[i]
+void DayNumberAddBatch(const int n, const int *restrict num, const int *restrict offset,
+                       int *restrict out){
+    for (int i = 0; i < n; i++) out[i] = num[i] + offset[i];
+}
+
+// Day-number form of DayOfWeek: 0 -> Sunday, ..., 6 -> Saturday.
+void DayNumberToWeekdayBatch(const int n, const int *restrict num, int *restrict weekday){
+    for (int i = 0; i < n; i++){
+        int w = (num[i] + 4) % 7;
+        weekday[i] = w + ((w < 0) ? 7 : 0);
+    }
+}
+
+// outyear[i]/outmonth[i]/outday[i] = DateAdd(year[i]/month[i]/day[i], offset[i]).
+// Works in blocks so the intermediate day numbers stay in L1.
+#define DATE_BATCH_BLOCK 1024
+
+void DateAddBatch(const int n, const int *restrict year, const int *restrict month,
+                  const int *restrict day, const int *restrict offset, int *restrict outyear,
+                  int *restrict outmonth, int *restrict outday){
+    int num[DATE_BATCH_BLOCK];
+    for (int i = 0; i < n; i += DATE_BATCH_BLOCK){
+        int len = (n - i < DATE_BATCH_BLOCK) ? n - i : DATE_BATCH_BLOCK;
+        DateToNumberBatch(len, year + i, month + i, day + i, num);
+        for (int j = 0; j < len; j++) num[j] += offset[i + j];
+        NumberToDateBatch(len, num, outyear + i, outmonth + i, outday + i);
+    }
+}
+
+// weekday[i] = DayOfWeek(year[i]/month[i]/day[i])
+void DayOfWeekBatch(const int n, const int *restrict year, const int *restrict month,
+                    const int *restrict day, int *restrict weekday){
+    int num[DATE_BATCH_BLOCK];
+    for (int i = 0; i < n; i += DATE_BATCH_BLOCK){
+        int len = (n - i < DATE_BATCH_BLOCK) ? n - i : DATE_BATCH_BLOCK;
+        DateToNumberBatch(len, year + i, month + i, day + i, num);
+        DayNumberToWeekdayBatch(len, num, weekday + i);
+    }
+}
+
+#endif
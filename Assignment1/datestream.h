@@ -0,0 +1,281 @@
+/* Bulk evaluation of date expressions.
+
+   The input file holds whitespace separated expressions in the three formats
+   of the interactive mode (yyyy/mm/dd, yyyy/mm/dd-YYYY/MM/DD, yyyy/mm/dd+x).
+   The file is memory-mapped (or block-read when it cannot be mapped) and
+   processed in rounds: each round is cut into one chunk per worker thread at
+   whitespace boundaries, every worker parses its chunk with a hand-written
+   digit parser and formats the answers into its own output buffer, and the
+   buffers are then written out in chunk order, so the output keeps the input
+   order and is byte-identical to the interactive mode. */
+
+#ifndef __DATESTREAM_H__
+#define __DATESTREAM_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "date.h"
+
+// Input bytes handed to each worker per round.
+#define STREAM_CHUNK (8 << 20)
+// Upper bound of the output of a single expression.
+#define STREAM_MAX_LINE 160
+
+typedef struct{
+    const char *begin, *end;   // input chunk
+    char *out;                 // formatted answers
+    size_t len, cap;
+    long long count, invalid;
+    int threaded;              // run on a thread of its own, to be joined
+} streamchunk_t;
+
+static inline int StreamIsSpace(const char c){
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Parse an optionally signed decimal number. Return the position after it, or
+// NULL when there is no digit or the magnitude is above INT_MAX.
+static inline const char *StreamParseInt(const char *p, const char *end, int *value){
+    int neg = 0;
+    if (p < end && (*p == '-' || *p == '+')){
+        neg = (*p == '-');
+        p++;
+    }
+    if (p >= end || (unsigned)(*p - '0') > 9)
+        return NULL;
+    int v = 0;
+    while (p < end && (unsigned)(*p - '0') <= 9){
+        int digit = *p++ - '0';
+        if (v > (INT_MAX - digit) / 10)
+            return NULL;
+        v = v * 10 + digit;
+    }
+    *value = neg ? -v : v;
+    return p;
+}
+
+// Parse yyyy/mm/dd. The year is unsigned here, as a leading '-' would be
+// taken for the subtraction operator.
+static inline const char *StreamParseDate(const char *p, const char *end, date *d){
+    if (p >= end || *p == '-' || *p == '+') return NULL;
+    if (!(p = StreamParseInt(p, end, &d->year)) || p >= end || *p++ != '/') return NULL;
+    if (!(p = StreamParseInt(p, end, &d->month)) || p >= end || *p++ != '/') return NULL;
+    if (!(p = StreamParseInt(p, end, &d->day))) return NULL;
+    if (d->month < 1 || d->month > 12 || d->day < 1) return NULL;
+    return p;
+}
+
+static inline char *StreamPuts(char *o, const char *s){
+    while (*s) *o++ = *s++;
+    return o;
+}
+
+static inline char *StreamPutInt(char *o, int v){
+    char tmp[12];
+    int k = 0;
+    unsigned u = (v < 0) ? -(unsigned)v : (unsigned)v;
+    if (v < 0) *o++ = '-';
+    do { tmp[k++] = '0' + u % 10; u /= 10; } while (u);
+    while (k) *o++ = tmp[--k];
+    return o;
+}
+
+// "Month d, y"
+static inline char *StreamPutDate(char *o, const date d){
+    o = StreamPuts(o, monthname[d.month]);
+    *o++ = ' ';
+    o = StreamPutInt(o, d.day);
+    *o++ = ','; *o++ = ' ';
+    return StreamPutInt(o, d.year);
+}
+
+// Evaluate one expression token [p, end) and append the answer to o.
+static char *StreamEval(const char *p, const char *end, char *o, streamchunk_t *chunk){
+    date date1, date2;
+    int n;
+    const char *q = StreamParseDate(p, end, &date1);
+    if (q && q == end){
+        o = StreamPutDate(o, date1);
+        o = StreamPuts(o, " is ");
+        o = StreamPuts(o, weekday[DayOfWeek(date1)]);
+        return StreamPuts(o, ".\n\n");
+    }
+    if (q && *q == '-' && (q = StreamParseDate(q + 1, end, &date2)) && q == end){
+        int x = DateSub(date1, date2);
+        o = StreamPutInt(o, (x < 0) ? -x : x);
+        o = StreamPuts(o, " days from ");
+        o = StreamPutDate(o, (x < 0) ? date2 : date1);
+        o = StreamPuts(o, " to ");
+        o = StreamPutDate(o, (x < 0) ? date1 : date2);
+        return StreamPuts(o, "\n\n");
+    }
+    q = StreamParseDate(p, end, &date1);
+    if (q && *q == '+' && (q = StreamParseInt(q + 1, end, &n)) && q == end){
+        date2 = DateAdd(date1, n);
+        o = StreamPutInt(o, (n < 0) ? -n : n);
+        o = StreamPuts(o, (n < 0) ? " days before " : " days after ");
+        o = StreamPutDate(o, date1);
+        o = StreamPuts(o, " is ");
+        o = StreamPutDate(o, date2);
+        return StreamPuts(o, "\n\n");
+    }
+    chunk->invalid++;
+    o = StreamPuts(o, "Invalid input ");
+    int len = (end - p < STREAM_MAX_LINE - 32) ? (int)(end - p) : STREAM_MAX_LINE - 32;
+    memcpy(o, p, len);
+    return StreamPuts(o + len, "\n\n");
+}
+
+static void *StreamWorker(void *arg){
+    streamchunk_t *chunk = (streamchunk_t*)arg;
+    const char *p = chunk->begin, *end = chunk->end;
+    chunk->len = 0;
+    chunk->count = 0;
+    while (1){
+        while (p < end && StreamIsSpace(*p)) p++;
+        if (p >= end) break;
+        const char *token = p;
+        while (p < end && !StreamIsSpace(*p)) p++;
+        if (chunk->cap - chunk->len < STREAM_MAX_LINE){
+            size_t cap = chunk->cap ? 2 * chunk->cap : STREAM_CHUNK;
+            char *out = (char*)realloc(chunk->out, cap);
+            if (out == NULL){
+                perror("Unable to allocate output buffer");
+                exit(EXIT_FAILURE);
+            }
+            chunk->out = out;
+            chunk->cap = cap;
+        }
+        chunk->len = StreamEval(token, p, chunk->out + chunk->len, chunk) - chunk->out;
+        chunk->count++;
+    }
+    return NULL;
+}
+
+// Read fd to its end into a malloc'ed buffer, starting from cap bytes and
+// doubling. Return the buffer and its length in *size, or NULL on error.
+static char *StreamReadAll(int fd, size_t cap, size_t *size){
+    size_t got = 0;
+    char *data = (char*)malloc(cap);
+    if (data == NULL){
+        perror("Unable to allocate input buffer");
+        return NULL;
+    }
+    while (1){
+        if (got == cap){
+            char *grown = (char*)realloc(data, 2 * cap);
+            if (grown == NULL){
+                perror("Unable to allocate input buffer");
+                free(data);
+                return NULL;
+            }
+            data = grown;
+            cap *= 2;
+        }
+        ssize_t r = read(fd, data + got, cap - got);
+        if (r == 0) break;
+        if (r < 0){
+            perror("Error reading input");
+            free(data);
+            return NULL;
+        }
+        got += r;
+    }
+    *size = got;
+    return data;
+}
+
+// Evaluate every expression of the file at path and write the answers to out
+// using the given number of worker threads. Regular files are mapped, pipes
+// and other streams are read to their end. Return the number of expressions,
+// or -1 if the input cannot be read or the output cannot be written.
+long long DateStream(const char *path, FILE *out, int threads){
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0){
+        perror("Unable to open input");
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    size_t size = 0;
+    int mapped = 0;
+    char *data = NULL;
+    if (S_ISREG(st.st_mode) && st.st_size > 0){
+        size = st.st_size;
+        data = (char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED){
+            mapped = 1;
+            madvise(data, size, MADV_SEQUENTIAL);
+        }else{
+            // Not mappable
+            data = StreamReadAll(fd, size + 1, &size);
+        }
+    }else if (!S_ISREG(st.st_mode)){
+        data = StreamReadAll(fd, STREAM_CHUNK, &size);
+    }
+    close(fd);
+    if (data == NULL && !(S_ISREG(st.st_mode) && st.st_size == 0))
+        return -1;
+
+    if (threads < 1) threads = 1;
+    streamchunk_t *chunk = (streamchunk_t*)calloc(threads, sizeof(streamchunk_t));
+    pthread_t *tid = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    if (chunk == NULL || tid == NULL){
+        perror("Unable to allocate worker state");
+        exit(EXIT_FAILURE);
+    }
+
+    long long total = 0, invalid = 0;
+    const char *p = data, *end = data + size;
+    while (p < end){
+        // Cut the next round into chunks that end on whitespace
+        int used = 0;
+        for ( ; used < threads && p < end; used++){
+            const char *q = (end - p > STREAM_CHUNK) ? p + STREAM_CHUNK : end;
+            while (q < end && !StreamIsSpace(*q)) q++;
+            chunk[used].begin = p;
+            chunk[used].end = q;
+            p = q;
+        }
+        // A chunk whose thread cannot be started is done here instead
+        for (int i = 1; i < used; i++)
+            chunk[i].threaded = (pthread_create(&tid[i], NULL, StreamWorker, &chunk[i]) == 0);
+        StreamWorker(&chunk[0]);
+        for (int i = 1; i < used; i++){
+            if (chunk[i].threaded)
+                pthread_join(tid[i], NULL);
+            else
+                StreamWorker(&chunk[i]);
+        }
+        for (int i = 0; i < used; i++){
+            if (fwrite(chunk[i].out, 1, chunk[i].len, out) != chunk[i].len){
+                perror("Error writing answers");
+                total = -1;
+                break;
+            }
+            total += chunk[i].count;
+            invalid += chunk[i].invalid;
+            chunk[i].invalid = 0;
+        }
+        if (total < 0) break;
+    }
+    if (invalid)
+        fprintf(stderr, "%lld invalid expressions\n", invalid);
+
+    for (int i = 0; i < threads; i++) free(chunk[i].out);
+    free(chunk);
+    free(tid);
+    if (mapped) munmap(data, size);
+    else free(data);
+    return total;
+}
+
+#endif
@@ -6,67 +6,68 @@
 // 4. Merge sort
 // 5. Heap sort
 //
+// and, beyond those, parallel merge and sample sorts on a work-stealing task
+// pool, a block-partition quicksort, an introsort with heapsort fallback, an
+// adaptive powersort, LSD and American flag radix sorts, and bottom-up and
+// 4-/8-ary heapsorts. The recursive sorts finish ranges of up to 64 keys with
+// the SIMD sorting networks of sortnet.h.
+//
+// The benchmark runs every method on heap-allocated inputs of several sizes
+// and distributions, times warmup + repeated runs on the monotonic clock and
+// reports median and percentiles, CPU time and, where the CPU exposes them,
+// the hardware counters of perfcounter.h per key; run with -h for the
+// options. Files larger than memory are sorted by the external merge sort of
+// externalsort.h.
+//
+// Build with the math library (benchmark.h) and POSIX threads (taskpool.h):
+//
+//     gcc -O2 Assignment2.c -o Assignment2 -lm -pthread
+//
 // author: C. H. Chen
 // date: 2024/09/24
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 
-const char sortingmethod[7][20] = {"Insertion", "Binary Insertion", "Selection", "Quick", "Non-recursive Quick", "Merge", "Heap"};
+#include "taskpool.h"
+#include "radixsort.h"
+#include "benchmark.h"
+#include "externalsort.h"
+#include "sortnet.h"
+#include "recordsort.h"
+#include "gensort.h"
 
-void insertionsort(const int n, int x[]){
-    int y, j, k = x[0];
-    for (int i = 2; i <= n; i++)
-    {
-        y = x[i]; x[0] = y;
-        j = i - 1;
-        while (x[j] > y)
-        {
-            x[j+1] = x[j]; j--;
-        }
-        x[j+1] = y;
-    }
-    x[0] = k;
-    return;
-}
+// The seven sorts for every key type, from gensort.h. Insertion, binary
+// insertion, selection and heap sort of ints are the int32 instances; quick,
+// non-recursive quick and merge sort keep int versions of their own below,
+// which take random pivots, finish short ranges with the sorting networks of
+// sortnet.h and sort ranges a[l..r].
+typedef struct {
+    long long key, value;
+} pair_t;
 
-void binaryinsertionsort(const int n, int x[]){
-    int y, l, r, m;
-    for (int i = 2; i < n+1; i++)
-    {
-        y = x[i];
-        l = 1; r = i - 1;
-        while (l <= r)
-        {
-            m = (l + r) >> 1;
-            if(y < x[m]) r = m - 1; else l = m + 1;
-        }
-        for (int j = i - 1; j >= l; j--) x[j+1] = x[j];       
-        x[l] = y;
-    }
-    return;
-}
+#define LESS_VALUE(a, b) ((a) < (b))
+#define LESS_PAIR(a, b) ((a).key < (b).key)
+#define KEY_VALUE(a) (a)
+#define KEY_PAIR(a) ((a).key)
 
-void selectionsort(const int n, int x[]){
-    int y, k;
-    for (int i = 1; i < n; i++)
-    {
-        y = x[i]; k = i;
-        for (int j = i + 1; j <= n; j++)
-        {
-            if (x[j] < y)
-            {
-                y = x[j]; k = j;
-            }
-        }
-        x[k] = x[i]; x[i] = y;
-    }
-    return;
-}
+DEFINE_INTEGRAL_SORTS(_int32, int, LESS_VALUE, KEY_VALUE, uint32_t, 32)
+DEFINE_INTEGRAL_SORTS(_int64, long long, LESS_VALUE, KEY_VALUE, uint64_t, 64)
+DEFINE_SORTS(_double, double, LESS_VALUE)
+DEFINE_INTEGRAL_SORTS(_pair, pair_t, LESS_PAIR, KEY_PAIR, uint64_t, 64)
 
-void quicksort(int a[], const int l, const int r){
-    int t, i = l, j = r, p = a[rand() % (r - l + 1) + l];
+void insertionsort(const int n, int x[]){ insertionsort_int32(n, x); }
+void binaryinsertionsort(const int n, int x[]){ binaryinsertionsort_int32(n, x); }
+void selectionsort(const int n, int x[]){ selectionsort_int32(n, x); }
+
+// Hoare partition of a[*i..*j] around the value p, which is in the range.
+// On return *j < *i, a[..*j] <= p, a[*i..] >= p and the keys in between
+// equal p.
+static inline void hoarepartition(int a[], int *pi, int *pj, const int p){
+    int i = *pi, j = *pj, t;
     while (i <= j)
     {
         while (a[i] < p) i++;
@@ -77,6 +78,17 @@ void quicksort(int a[], const int l, const int r){
             i++; j--;
         }
     }
+    *pi = i; *pj = j;
+}
+
+void quicksort(int a[], const int l, const int r){
+    if (r - l < SORTNET_MAX)
+    {
+        sortnet(a + l, r - l + 1);
+        return;
+    }
+    int i = l, j = r;
+    hoarepartition(a, &i, &j, a[rand() % (r - l + 1) + l]);
     if (l < j) quicksort(a, l, j);
     if (i < r) quicksort(a, i, r);
 }
@@ -88,39 +100,32 @@ int nonrecursivequicksort(const int n, int x[]){
         tmp = tmp / 2;
         lgn++;
     }
+#ifdef DEBUG
     printf("%d",lgn);
+#endif
     int l[2*lgn], r[2*lgn]; //stack
     int s = 1, stack_height = 1;
     l[s] = 1; r[s] = n;
     while (s > 0)
     {
         l[0] = l[s]; r[0] = r[s]; s--;
-        int k = rand()%(r[0]-l[0]+1)+l[0];
-        int i = l[0], j = r[0], p = x[k];
-        while (i <= j)
-        {
-            while (x[i] < p) { i++;}
-            while (p < x[j]) { j--;}
-            if (i <= j)
-            {
-                int z = x[i]; x[i] = x[j]; x[j] = z;
-                i++; j--;
-            }
-        }
-        if (l[0] < j) 
+        // Push the larger side and go on with the smaller one, so at most
+        // log2 n ranges wait on the stack
+        while (r[0] - l[0] >= SORTNET_MAX)
         {
-            s++; 
-            l[s] = l[0]; r[s] = j;
-            if(stack_height < s) stack_height = s;
-        }
-        if (i < r[0]) 
-        {
-            s++; 
-            l[s] = i; r[s] = r[0];
+            int k = rand()%(r[0]-l[0]+1)+l[0];
+            int i = l[0], j = r[0];
+            hoarepartition(x, &i, &j, x[k]);
+            s++;
+            if (j - l[0] < r[0] - i) { l[s] = i; r[s] = r[0]; r[0] = j; }
+            else { l[s] = l[0]; r[s] = j; l[0] = i; }
             if(stack_height < s) stack_height = s;
         }
+        sortnet(x + l[0], r[0] - l[0] + 1);
     }
+#ifdef DEBUG
     printf("stack_height = %d\n",stack_height);
+#endif
     return stack_height;
 }
 
@@ -142,7 +147,8 @@ void merge(int a[], const int l, const int m, const int r){
 }
 
 void mergesort(int a[], const int l, const int r){
-    if (l < r)
+    if (r - l < SORTNET_MAX) sortnet(a + l, r - l + 1);
+    else
     {
         int m = (l + r) / 2;
         mergesort(a, l, m);
@@ -151,198 +157,1435 @@ void mergesort(int a[], const int l, const int r){
     }
 }
 
-void sift(int a[], const int r, const int n){
-    int i = r, j = 2 * i, x = a[i];
-    while (j <= n)
+void sift(int a[], const int r, const int n){ gen_sift_int32(a, r, n); }
+void heapsort(const int n, int x[]){ heapsort_int32(n, x); }
+
+// Floyd's bottom-up sift: walk down to a leaf along the larger children with
+// one comparison per level, then climb back up to where x belongs. Most keys
+// taken from the bottom return close to the bottom, so this needs about half
+// the comparisons of sift.
+void bottomupsift(int a[], const int r, const int n){
+    int x = a[r], i = r, j = 2 * r;
+    while (j < n)
     {
-        if (j < n) { if(a[j] < a[j + 1]) j++;}
-        if (x > a[j]) break;
+        if (a[j] < a[j + 1]) j++;
         a[i] = a[j]; i = j; j = 2 * i;
     }
+    if (j == n) { a[i] = a[j]; i = j; }
+    while (i > r && a[i / 2] < x)
+    {
+        a[i] = a[i / 2]; i = i / 2;
+    }
     a[i] = x;
 }
 
-void heapsort(const int n, int x[]){
-    int r = n / 2;
-    while (r > 0)
+void bottomupheapsort(const int n, int x[]){
+    for (int r = n / 2; r > 0; r--) sift(x, r, n);
+    for (int m = n; m > 1; m--)
     {
-        sift(x, r, n); r--;
+        int y = x[1]; x[1] = x[m]; x[m] = y;
+        bottomupsift(x, 1, m - 1);
     }
-    int m = n;
-    while (m > 0)
+}
+
+// d-ary heap (0-based): the children of node k are nodes d*k+1..d*k+d, next
+// to each other, and the heap is log2(d) times shallower. The nodes are
+// sorted in a copy on a 64-byte aligned buffer b with node k at b[k + d - 1],
+// so the children of k start at b[d*(k+1)], a multiple of d: a group of
+// children (16 bytes for d = 4, 32 for d = 8) never straddles a cache line
+// and a level costs one line instead of a miss per level. The copy costs n
+// ints of memory and two linear passes.
+static inline void darysift(int h[], int k, const int n, const int d){
+    int x = h[k], c;
+    while ((c = d * k + 1) < n)
     {
-        int y = x[1]; x[1] = x[m]; x[m] = y;
-        m--; sift(x, 1, m);
+        int last = (c + d < n) ? c + d : n, m = c;
+        for (int j = c + 1; j < last; j++) if (h[m] < h[j]) m = j;
+        if (!(x < h[m])) break;
+        h[k] = h[m]; k = m;
     }
+    h[k] = x;
 }
 
-#ifdef DEBUG
-int check(const int n, int arr[]){
-    for (int i = 1; i < n; i++) if (arr[i] > arr[i+1]) return 1;
-    return 0;
+static inline void daryheapsort(const int n, int x[], const int d){
+    if (n < 2) return;
+    size_t bytes = ((size_t)n + d - 1) * sizeof(int);
+    int *b = (int*)aligned_alloc(64, (bytes + 63) & ~(size_t)63);
+    if (b == NULL)
+    {
+        perror("Unable to allocate heap");
+        exit(EXIT_FAILURE);
+    }
+    int *h = b + d - 1;
+    memcpy(h, x + 1, (size_t)n * sizeof(int));
+    for (int k = (n - 2) / d; k >= 0; k--) darysift(h, k, n, d);
+    for (int m = n - 1; m > 0; m--)
+    {
+        int y = h[0]; h[0] = h[m]; h[m] = y;
+        darysift(h, 0, m, d);
+    }
+    memcpy(x + 1, h, (size_t)n * sizeof(int));
+    free(b);
+}
+
+void quaternaryheapsort(const int n, int x[]){ daryheapsort(n, x, 4); }
+void octonaryheapsort(const int n, int x[]){ daryheapsort(n, x, 8); }
+
+// Introsort in the style of pattern-defeating quicksort: ninther or median of 3
+// pivots, a sorting network (sortnet.h) for short ranges, and heapsort (the heapsort/sift
+// above) once the depth budget of 2 log2 n levels is used up. A partition that
+// needed no swap hints at presorted input and is finished by an insertion sort
+// that gives up after a few moves; sorted and reversed inputs are caught
+// before any partitioning.
+#define INTRO_THRESHOLD SORTNET_MAX
+#define NINTHER_THRESHOLD 128
+#define PARTIAL_INSERTION_LIMIT 8
+
+void sort3(int a[], const int i, const int j, const int k){
+    int t;
+    if (a[j] < a[i]) { t = a[i]; a[i] = a[j]; a[j] = t; }
+    if (a[k] < a[j]) { t = a[j]; a[j] = a[k]; a[k] = t; }
+    if (a[j] < a[i]) { t = a[i]; a[i] = a[j]; a[j] = t; }
+}
+
+// Insertion sort that stops after PARTIAL_INSERTION_LIMIT moves.
+// Return 1 if a[l..r] ended up sorted.
+int partialinsertionsort(int a[], const int l, const int r){
+    int moves = 0;
+    for (int i = l + 1; i <= r; i++)
+    {
+        int y = a[i], j = i - 1;
+        while (j >= l && a[j] > y) { a[j+1] = a[j]; j--; }
+        a[j+1] = y;
+        moves += i - 1 - j;
+        if (moves > PARTIAL_INSERTION_LIMIT) return i == r;
+    }
+    return 1;
+}
+
+// Partition a[l..r] around the pivot a[l] into < pivot | pivot | >= pivot.
+// Return the final pivot position; *swapped is 0 if the range was already
+// partitioned.
+int partitionright(int a[], const int l, const int r, int *swapped){
+    int p = a[l], i = l, j = r + 1, t;
+    do i++; while (i <= r && a[i] < p);
+    do j--; while (j > l && !(a[j] < p));
+    *swapped = (i < j);
+    while (i < j)
+    {
+        t = a[i]; a[i] = a[j]; a[j] = t;
+        do i++; while (a[i] < p);
+        do j--; while (!(a[j] < p));
+    }
+    a[l] = a[j]; a[j] = p;
+    return j;
 }
-#endif
 
-int main(void){
-    unsigned int arr_size = 100, count = 0;
-    clock_t start, end;
-    double cpu_time_used[7][100] = {0};
-    do{
-        int i = 0;
-        for ( ; i < 7; i++)
+// Partition a[l..r] around the pivot a[l] into <= pivot | > pivot. Used when
+// the pivot equals the element before the range, so the left part is a run of
+// equal keys. Return the last position of the left part.
+int partitionleft(int a[], const int l, const int r){
+    int p = a[l], i = l, j = r + 1, t;
+    do j--; while (p < a[j]);
+    do i++; while (i < j && !(p < a[i]));
+    while (i < j)
+    {
+        t = a[i]; a[i] = a[j]; a[j] = t;
+        do j--; while (p < a[j]);
+        do i++; while (!(p < a[i]));
+    }
+    a[l] = a[j]; a[j] = p;
+    return j;
+}
+
+// Move the median of 3 (ninther for large ranges) of a[l..r] to a[l].
+void movepivot(int a[], const int l, const int r){
+    int n = r - l + 1, m = l + n / 2, t;
+    if (n > NINTHER_THRESHOLD)
+    {
+        int s = n / 8;
+        sort3(a, l, l + s, l + 2 * s);
+        sort3(a, m - s, m, m + s);
+        sort3(a, r - 2 * s, r - s, r);
+        sort3(a, l + s, m, r - s);
+    }
+    else sort3(a, l, m, r);
+    t = a[l]; a[l] = a[m]; a[m] = t;
+}
+
+void introsortloop(int a[], int l, int r, int depth, int leftmost){
+    while (r - l + 1 > INTRO_THRESHOLD)
+    {
+        if (depth == 0)
+        {
+            heapsort(r - l + 1, a + l - 1);
+            return;
+        }
+        depth--;
+
+        int n = r - l + 1, t;
+        movepivot(a, l, r);
+
+        // Equal to the previous pivot: skip the run of equal keys
+        if (!leftmost && !(a[l-1] < a[l]))
         {
-            srand(arr_size);
-            int arr[arr_size + 1];
-            for (int j = 1; j <= arr_size; j++) arr[j] = j;
-            for (int j = arr_size - 1; j > 0; j--)
+            l = partitionleft(a, l, r) + 1;
+            continue;
+        }
+
+        int swapped;
+        int k = partitionright(a, l, r, &swapped);
+        int ln = k - l, rn = r - k;
+
+        if (ln < n / 8 || rn < n / 8)
+        {   // Unbalanced, break up patterns that may have caused it
+            if (ln >= INTRO_THRESHOLD)
             {
-                int k = rand()%(j+1)+1;
-                int temp = arr[j];
-                arr[j] = arr[k];
-                arr[k] = temp;
+                t = a[l]; a[l] = a[l + ln / 4]; a[l + ln / 4] = t;
+                t = a[k-1]; a[k-1] = a[k - ln / 4]; a[k - ln / 4] = t;
             }
-            switch (i)
+            if (rn >= INTRO_THRESHOLD)
             {
-            case 0:
-                printf("%s sort array size %d ...\n",sortingmethod[i], arr_size);
-                start = clock();
-                insertionsort(arr_size, arr);
-                end = clock();
-                cpu_time_used[i][count] = ((double) (end - start)) / CLOCKS_PER_SEC;
-                printf("Associated cpu time %.3f\n\n",cpu_time_used[i][count]);
-                break;
-            case 1:
-                printf("%s sort array size %d ...\n",sortingmethod[i], arr_size);
-                start = clock();
-                binaryinsertionsort(arr_size, arr);
-                end = clock();
-                cpu_time_used[i][count] = ((double) (end - start)) / CLOCKS_PER_SEC;
-                printf("Associated cpu time %.3f\n\n",cpu_time_used[i][count]);
-                break;
-            case 2:
-                printf("%s sort array size %d ...\n",sortingmethod[i], arr_size);
-                start = clock();
-                selectionsort(arr_size, arr);
-                end = clock();
-                cpu_time_used[i][count] = ((double) (end - start)) / CLOCKS_PER_SEC;
-                printf("Associated cpu time %.3f\n\n",cpu_time_used[i][count]);
-                break;
-            case 3:
-                printf("%s sort array size %d ...\n",sortingmethod[i], arr_size);
-                start = clock();
-                quicksort(arr, 1, arr_size);
-                end = clock();
-                cpu_time_used[i][count] = ((double) (end - start)) / CLOCKS_PER_SEC;
-                printf("Associated cpu time %.3f\n\n",cpu_time_used[i][count]);
-                break;
-            case 4:
-                printf("%s sort array size %d ...\n",sortingmethod[i], arr_size);
-                start = clock();
-                nonrecursivequicksort(arr_size, arr);
-                end = clock();
-                cpu_time_used[i][count] = ((double) (end - start)) / CLOCKS_PER_SEC;
-                printf("Associated cpu time %.3f\n\n",cpu_time_used[i][count]);
-                break;
-            case 5:
-                printf("%s sort array size %d ...\n",sortingmethod[i], arr_size);
-                start = clock();
-                mergesort(arr, 1, arr_size);
-                end = clock();
-                cpu_time_used[i][count] = ((double) (end - start)) / CLOCKS_PER_SEC;
-                printf("Associated cpu time %.3f\n\n",cpu_time_used[i][count]);
-                break;
-            case 6:
-                printf("%s sort array size %d ...\n",sortingmethod[i], arr_size);
-                start = clock();
-                heapsort(arr_size, arr);
-                end = clock();
-                cpu_time_used[i][count] = ((double) (end - start)) / CLOCKS_PER_SEC;
-                printf("Associated cpu time %.3f\n\n",cpu_time_used[i][count]);
-                break;
+                t = a[k+1]; a[k+1] = a[k + 1 + rn / 4]; a[k + 1 + rn / 4] = t;
+                t = a[r]; a[r] = a[r - rn / 4]; a[r - rn / 4] = t;
             }
-#ifdef DEBUG
-            if(check(arr_size, arr)){
-                printf("Error\n");
-                return -1;
+        }
+        else if (!swapped && partialinsertionsort(a, l, k - 1) && partialinsertionsort(a, k + 1, r))
+            return;
+
+        // Recurse into the smaller side, loop on the larger one
+        if (ln < rn)
+        {
+            introsortloop(a, l, k - 1, depth, leftmost);
+            l = k + 1;
+            leftmost = 0;
+        }
+        else
+        {
+            introsortloop(a, k + 1, r, depth, 0);
+            r = k - 1;
+        }
+    }
+    sortnet(a + l, r - l + 1);
+}
+
+void introsort(const int n, int x[]){
+    int i = 1, t;
+    while (i < n && x[i] <= x[i+1]) i++;
+    if (i >= n) return;
+    if (i == 1)
+    {   // Strictly decreasing input is reversed
+        while (i < n && x[i] > x[i+1]) i++;
+        if (i >= n)
+        {
+            for (int l = 1, r = n; l < r; l++, r--) { t = x[l]; x[l] = x[r]; x[r] = t; }
+            return;
+        }
+    }
+    int depth = 0;
+    for (int m = n; m > 1; m >>= 1) depth += 2;
+    introsortloop(x, 1, n, depth, 1);
+}
+
+// BlockQuicksort (Edelkamp and Weiss): the partition first compares a block
+// of QUICK_BLOCK keys from each end with the pivot and only records the
+// offsets of the misplaced ones, with the comparison result added to the
+// count instead of branched on, then swaps the recorded pairs. The inner
+// loops have no data-dependent branches, so random input no longer
+// mispredicts about every other comparison. Ranges wait on an explicit stack
+// of the larger sides, at most log2 n of them. As in introsort, a range that
+// is still unsorted after 2 log2 n partitions is heapsorted, so input that
+// defeats the median-of-3 pivot costs O(n log n) instead of O(n^2).
+#define QUICK_BLOCK 128
+
+// Partition a[l..r] around the pivot a[l] into < pivot | pivot | >= pivot
+// and return the position of the pivot.
+int blockpartition(int a[], const int l, const int r){
+    const int p = a[l];
+    int first = l + 1, last = r, t;  // a[first..last] is not partitioned yet
+    unsigned char offl[QUICK_BLOCK], offr[QUICK_BLOCK];
+    int startl = 0, numl = 0, startr = 0, numr = 0;
+    while (last - first + 1 > 2 * QUICK_BLOCK)
+    {
+        if (numl == 0)
+        {
+            startl = 0;
+            for (int k = 0; k < QUICK_BLOCK; k++)
+            {
+                offl[numl] = k;
+                numl += !(a[first + k] < p);
             }
-#endif
         }
-        count++;
-        if (arr_size < 1000) arr_size = arr_size+100;
-        else if (arr_size < 10000 ) arr_size = arr_size+1000;
-        else arr_size = arr_size+10000;
-    }while (arr_size < 100000);
-    do{
-        int i = 3;
-        for ( ; i < 7; i++)
+        if (numr == 0)
         {
-            srand(arr_size);
-            int arr[arr_size + 1];
-            for (int j = 1; j <= arr_size; j++) arr[j] = j;
-            for (int j = arr_size - 1; j > 0; j--)
+            startr = 0;
+            for (int k = 0; k < QUICK_BLOCK; k++)
             {
-                int k = rand()%(j+1)+1;
-                int temp = arr[j];
-                arr[j] = arr[k];
-                arr[k] = temp;
+                offr[numr] = k;
+                numr += (a[last - k] < p);
             }
-            switch (i)
+        }
+        int num = (numl < numr) ? numl : numr;
+        for (int k = 0; k < num; k++)
+        {
+            int *u = &a[first + offl[startl + k]], *v = &a[last - offr[startr + k]];
+            t = *u; *u = *v; *v = t;
+        }
+        numl -= num; numr -= num;
+        startl += num; startr += num;
+        if (numl == 0) first += QUICK_BLOCK;
+        if (numr == 0) last -= QUICK_BLOCK;
+    }
+    // The rest, including a block with offsets left over, the plain way
+    int i = first, j = last;
+    while (1)
+    {
+        while (i <= j && a[i] < p) i++;
+        while (i <= j && !(a[j] < p)) j--;
+        if (i > j) break;
+        t = a[i]; a[i] = a[j]; a[j] = t;
+        i++; j--;
+    }
+    a[l] = a[i - 1]; a[i - 1] = p;
+    return i - 1;
+}
+
+void blockquicksort(const int n, int x[]){
+    int lo[32], hi[32], dep[32], s = 0, l = 1, r = n, depth = 0;
+    for (int m = n; m > 1; m >>= 1) depth += 2;
+    while (1)
+    {
+        while (r - l >= SORTNET_MAX)
+        {
+            if (depth-- == 0)
             {
-            case 3:
-                printf("%s sort array size %d ...\n",sortingmethod[i], arr_size);
-                start = clock();
-                quicksort(arr, 1, arr_size);
-                end = clock();
-                cpu_time_used[i][count] = ((double) (end - start)) / CLOCKS_PER_SEC;
-                printf("Associated cpu time %.3f\n\n",cpu_time_used[i][count]);
-                break;
-            case 4:
-                printf("%s sort array size %d ...\n",sortingmethod[i], arr_size);
-                start = clock();
-                nonrecursivequicksort(arr_size, arr);
-                end = clock();
-                cpu_time_used[i][count] = ((double) (end - start)) / CLOCKS_PER_SEC;
-                printf("Associated cpu time %.3f\n\n",cpu_time_used[i][count]);
-                break;
-            case 5:
-                printf("%s sort array size %d ...\n",sortingmethod[i], arr_size);
-                start = clock();
-                mergesort(arr, 1, arr_size);
-                end = clock();
-                cpu_time_used[i][count] = ((double) (end - start)) / CLOCKS_PER_SEC;
-                printf("Associated cpu time %.3f\n\n",cpu_time_used[i][count]);
-                break;
-            case 6:
-                printf("%s sort array size %d ...\n",sortingmethod[i], arr_size);
-                start = clock();
-                heapsort(arr_size, arr);
-                end = clock();
-                cpu_time_used[i][count] = ((double) (end - start)) / CLOCKS_PER_SEC;
-                printf("Associated cpu time %.3f\n\n",cpu_time_used[i][count]);
+                heapsort(r - l + 1, x + l - 1);
+                r = l - 1;  // nothing left for the sorting network
                 break;
             }
-#ifdef DEBUG
-            if(check(arr_size, arr)){
-                printf("Error\n");
-                return -1;
+            movepivot(x, l, r);
+            // x[l-1] bounds the range from below; a pivot equal to it is the
+            // smallest key, and the keys equal to it are done
+            if (l > 1 && !(x[l-1] < x[l]))
+            {
+                l = partitionleft(x, l, r) + 1;
+                continue;
             }
-#endif
+            int k = blockpartition(x, l, r);
+            if (k - l < r - k) { lo[s] = k + 1; hi[s] = r; r = k - 1; }
+            else { lo[s] = l; hi[s] = k - 1; l = k + 1; }
+            dep[s++] = depth;
         }
-        count++;
-        arr_size = arr_size+10000;
-    }while (arr_size < 250000);
+        sortnet(x + l, r - l + 1);
+        if (s == 0) break;
+        s--;
+        l = lo[s]; r = hi[s]; depth = dep[s];
+    }
+}
 
-    FILE * fp;
-    fp = fopen ("mytable.txt", "w+");
-    for (int i = 0; i < 7; i++)
+// Powersort (Munro and Wild), a stable merge sort that adapts to presorted
+// input: natural runs are found from left to right, strictly descending ones
+// reversed, and runs shorter than MIN_RUN extended by binaryinsertionsort.
+// Each pair of neighbouring runs gets the power of their boundary, the depth
+// at which it would split the array in a balanced merge tree, and runs wait on
+// a stack until a boundary of lower power arrives, which gives merge costs
+// within n log2 n of optimal for the run lengths. The merges gallop: keys
+// already in place at both ends are skipped by exponential search, and once
+// one run wins GALLOP times in a row whole blocks are moved at once.
+#define MIN_RUN 32
+#define GALLOP 7
+
+// First position in a[lo..hi] with a key > key (hi + 1 if none), by
+// exponential then binary search from lo.
+static inline int gallopright(const int key, const int a[], int lo, const int hi){
+    int prev = lo - 1, step = 1;
+    while (lo <= hi && !(key < a[lo])) { prev = lo; lo += step; step <<= 1; }
+    int l = prev + 1, r = (lo <= hi) ? lo : hi + 1;
+    while (l < r)
+    {
+        int m = (l + r) >> 1;
+        if (key < a[m]) r = m; else l = m + 1;
+    }
+    return l;
+}
+
+// First position in a[lo..hi] with a key >= key (hi + 1 if none).
+static inline int gallopleft(const int key, const int a[], int lo, const int hi){
+    int prev = lo - 1, step = 1;
+    while (lo <= hi && a[lo] < key) { prev = lo; lo += step; step <<= 1; }
+    int l = prev + 1, r = (lo <= hi) ? lo : hi + 1;
+    while (l < r)
+    {
+        int m = (l + r) >> 1;
+        if (a[m] < key) l = m + 1; else r = m;
+    }
+    return l;
+}
+
+// Stable merge of the sorted runs a[l..m] and a[m+1..r] through buf.
+void gallopmerge(int a[], const int l, const int m, const int r, int buf[]){
+    int lo = gallopright(a[m + 1], a, l, m);
+    if (lo > m) return;
+    int end = gallopleft(a[m], a, m + 1, r) - 1;
+    int n1 = m - lo + 1, i = 0, j = m + 1, k = lo;
+    memcpy(buf, a + lo, n1 * sizeof(int));
+    while (i < n1 && j <= end)
+    {
+        int wins1 = 0, wins2 = 0;
+        while (i < n1 && j <= end)
+        {
+            if (a[j] < buf[i]) { a[k++] = a[j++]; wins1 = 0; if (++wins2 >= GALLOP) break; }
+            else { a[k++] = buf[i++]; wins2 = 0; if (++wins1 >= GALLOP) break; }
+        }
+        while (i < n1 && j <= end)
+        {
+            int c1 = gallopright(a[j], buf, i, n1 - 1) - i;
+            memcpy(a + k, buf + i, c1 * sizeof(int));
+            k += c1; i += c1;
+            if (i >= n1) break;
+            a[k++] = a[j++];
+            if (j > end) break;
+            int c2 = gallopleft(buf[i], a, j, end) - j;
+            memmove(a + k, a + j, c2 * sizeof(int));
+            k += c2; j += c2;
+            a[k++] = buf[i++];
+            if (c1 < GALLOP && c2 < GALLOP) break;
+        }
+    }
+    // The rest of the right run is in place already
+    memcpy(a + k, buf + i, (n1 - i) * sizeof(int));
+}
+
+// Length of the run starting at x[s], made ascending and at least MIN_RUN
+// long (or up to x[n]).
+int extendrun(int x[], const int s, const int n){
+    int e = s;
+    if (s < n && x[s+1] < x[s])
+    {
+        while (e < n && x[e+1] < x[e]) e++;
+        for (int l = s, r = e; l < r; l++, r--) { int t = x[l]; x[l] = x[r]; x[r] = t; }
+    }
+    else while (e < n && !(x[e+1] < x[e])) e++;
+    if (e - s + 1 < MIN_RUN)
+    {
+        e = (s + MIN_RUN - 1 < n) ? s + MIN_RUN - 1 : n;
+        binaryinsertionsort(e - s + 1, x + s - 1);
+    }
+    return e - s + 1;
+}
+
+// Power of the boundary between the runs x[s1..s1+n1-1] and x[s1+n1..s1+n1+n2-1]
+// of x[1..n]: the first bit in which the binary fractions of their midpoints
+// differ.
+static inline int nodepower(const int s1, const int n1, const int n2, const int n){
+    unsigned long long a = ((2ULL * (s1 - 1) + n1) << 31) / (2ULL * n);
+    unsigned long long b = ((2ULL * (s1 - 1) + 2ULL * n1 + n2) << 31) / (2ULL * n);
+    return __builtin_clz((unsigned)(a ^ b));
+}
+
+void powersort(const int n, int x[]){
+    if (n < 2) return;
+    int *buf = (int*)malloc(n * sizeof(int));
+    if (buf == NULL)
+    {
+        perror("Unable to allocate merge buffer");
+        exit(EXIT_FAILURE);
+    }
+    int start[64], power[64], top = 0;
+    int s1 = 1, n1 = extendrun(x, 1, n);
+    while (s1 + n1 <= n)
+    {
+        int s2 = s1 + n1, n2 = extendrun(x, s2, n);
+        int p = nodepower(s1, n1, n2, n);
+        while (top > 0 && power[top - 1] > p)
+        {
+            top--;
+            gallopmerge(x, start[top], s1 - 1, s1 + n1 - 1, buf);
+            n1 += s1 - start[top];
+            s1 = start[top];
+        }
+        start[top] = s1;
+        power[top++] = p;
+        s1 = s2; n1 = n2;
+    }
+    while (top > 0)
+    {
+        top--;
+        gallopmerge(x, start[top], s1 - 1, n, buf);
+        s1 = start[top];
+    }
+    free(buf);
+}
+
+// Selection on the partition of quicksort. introselect(n, x, k) leaves the
+// k-th smallest key in x[k] with no larger key before it and no smaller key
+// after it (nth_element), recursing only into the side that holds k. After
+// 2 log2 n partitions the remaining range is heapsorted, so a run of bad
+// pivots costs O(n log n) at worst. partialsort(n, x, k) leaves the k smallest
+// keys sorted in x[1..k].
+void introselect(const int n, int x[], const int k){
+    int l = 1, r = n, depth = 0;
+    if (k < 1 || k > n) return;
+    for (int m = n; m > 1; m >>= 1) depth += 2;
+    while (r - l >= SORTNET_MAX)
     {
-        for (int j = 0; j < 30; j++)
+        if (depth-- == 0)
         {
-            fprintf(fp, "%f ", cpu_time_used[i][j]);
+            heapsort(r - l + 1, x + l - 1);
+            return;
         }
-        fprintf(fp, "\n");
+        int i = l, j = r;
+        hoarepartition(x, &i, &j, x[rand() % (r - l + 1) + l]);
+        if (k <= j) r = j;
+        else if (k >= i) l = i;
+        else return;    // x[k] equals the pivot
     }
+    sortnet(x + l, r - l + 1);
+}
+
+void partialsort(const int n, int x[], const int k){
+    if (k < 1) return;
+    if (k >= n)
+    {
+        introsort(n, x);
+        return;
+    }
+    introselect(n, x, k);
+    introsort(k - 1, x);
+}
+
+// The k smallest keys of a stream in one pass and O(k) memory: a max-heap
+// (the sift of heapsort) holds the k smallest keys seen so far, and a new key
+// replaces its root when it is smaller.
+typedef struct {
+    int k, size;
+    int *heap;      // heap[1..size]
+} topk_t;
+
+topk_t *topk_create(const int k){
+    topk_t *t = (topk_t*)malloc(sizeof(topk_t));
+    if (t == NULL || (t->heap = (int*)malloc((k + 1) * sizeof(int))) == NULL)
+    {
+        perror("Unable to allocate top-k heap");
+        exit(EXIT_FAILURE);
+    }
+    t->k = k;
+    t->size = 0;
+    return t;
+}
+
+void topk_free(topk_t *t){
+    free(t->heap);
+    free(t);
+}
+
+void topk_push(topk_t *t, const int n, const int x[]){
+    int i = 0;
+    for ( ; i < n && t->size < t->k; i++)
+    {
+        t->heap[++t->size] = x[i];
+        if (t->size == t->k)
+            for (int r = t->k / 2; r > 0; r--) sift(t->heap, r, t->k);
+    }
+    for ( ; i < n; i++)
+        if (x[i] < t->heap[1])
+        {
+            t->heap[1] = x[i];
+            sift(t->heap, 1, t->k);
+        }
+}
+
+// Copy the keys kept so far, sorted, to out[1..] and return their number.
+int topk_result(const topk_t *t, int out[]){
+    memcpy(out + 1, t->heap + 1, t->size * sizeof(int));
+    introsort(t->size, out);
+    return t->size;
+}
+
+// Parallel merge sort on the work-stealing pool of taskpool.h. The halves are
+// sorted alternately into the array and into one scratch buffer allocated up
+// front, so every level is a single merge pass with no copying back, and the
+// merges themselves are split in parallel. Ranges below PARALLEL_CUTOFF are
+// sorted sequentially by the same method.
+#define PARALLEL_CUTOFF 8192
+
+taskpool_t *sortpool = NULL;
+
+typedef struct {
+    int *src, *dst;
+    int l, r, todst;
+} msort_task_t;
+
+typedef struct {
+    const int *a;
+    int l1, r1, l2, r2;
+    int *out;
+    int o;
+} pmerge_task_t;
+
+// Merge a[l1..r1] and a[l2..r2] into out[o..].
+void seqmerge(const int a[], int l1, const int r1, int l2, const int r2, int out[], int o){
+    while ((l1 <= r1)&&(l2 <= r2))
+    {
+        if (a[l2] < a[l1]) out[o++] = a[l2++];
+        else out[o++] = a[l1++];
+    }
+    while (l1 <= r1) out[o++] = a[l1++];
+    while (l2 <= r2) out[o++] = a[l2++];
+}
+
+// Sort src[l..r], leaving the result in dst[l..r] if todst and in src otherwise.
+void seqmsort(int src[], int dst[], const int l, const int r, const int todst){
+    if (r - l < SORTNET_MAX)
+    {
+        int *a = todst ? dst : src;
+        if (todst) for (int i = l; i <= r; i++) a[i] = src[i];
+        sortnet(a + l, r - l + 1);
+        return;
+    }
+    int m = (l + r) / 2;
+    seqmsort(src, dst, l, m, !todst);
+    seqmsort(src, dst, m + 1, r, !todst);
+    if (todst) seqmerge(src, l, m, m + 1, r, dst, l);
+    else seqmerge(dst, l, m, m + 1, r, src, l);
+}
+
+// Split the larger run at its middle, find the matching split of the other
+// run by binary search and merge both sides in parallel.
+void pmerge(void *arg){
+    pmerge_task_t *t = (pmerge_task_t*)arg;
+    int n1 = t->r1 - t->l1 + 1, n2 = t->r2 - t->l2 + 1;
+    if (n1 + n2 <= PARALLEL_CUTOFF)
+    {
+        seqmerge(t->a, t->l1, t->r1, t->l2, t->r2, t->out, t->o);
+        return;
+    }
+    int m1, m2, om;
+    if (n1 >= n2)
+    {   // a[m1] goes after every element of run 2 smaller than it
+        m1 = (t->l1 + t->r1) / 2;
+        int lo = t->l2, hi = t->r2 + 1;
+        while (lo < hi) { int m = (lo + hi) / 2; if (t->a[m] < t->a[m1]) lo = m + 1; else hi = m; }
+        m2 = lo;
+        om = t->o + (m1 - t->l1) + (m2 - t->l2);
+        t->out[om] = t->a[m1];
+        pmerge_task_t left = {t->a, t->l1, m1 - 1, t->l2, m2 - 1, t->out, t->o};
+        pmerge_task_t right = {t->a, m1 + 1, t->r1, m2, t->r2, t->out, om + 1};
+        atomic_int pending = 0;
+        taskpool_spawn(sortpool, pmerge, &left, &pending);
+        pmerge(&right);
+        taskpool_wait(sortpool, &pending);
+    }
+    else
+    {   // a[m2] goes after every element of run 1 not greater than it
+        m2 = (t->l2 + t->r2) / 2;
+        int lo = t->l1, hi = t->r1 + 1;
+        while (lo < hi) { int m = (lo + hi) / 2; if (t->a[m2] < t->a[m]) hi = m; else lo = m + 1; }
+        m1 = lo;
+        om = t->o + (m1 - t->l1) + (m2 - t->l2);
+        t->out[om] = t->a[m2];
+        pmerge_task_t left = {t->a, t->l1, m1 - 1, t->l2, m2 - 1, t->out, t->o};
+        pmerge_task_t right = {t->a, m1, t->r1, m2 + 1, t->r2, t->out, om + 1};
+        atomic_int pending = 0;
+        taskpool_spawn(sortpool, pmerge, &left, &pending);
+        pmerge(&right);
+        taskpool_wait(sortpool, &pending);
+    }
+}
+
+void pmsort(void *arg){
+    msort_task_t *t = (msort_task_t*)arg;
+    if (t->r - t->l < PARALLEL_CUTOFF)
+    {
+        seqmsort(t->src, t->dst, t->l, t->r, t->todst);
+        return;
+    }
+    int m = (t->l + t->r) / 2;
+    msort_task_t left = {t->src, t->dst, t->l, m, !t->todst};
+    msort_task_t right = {t->src, t->dst, m + 1, t->r, !t->todst};
+    atomic_int pending = 0;
+    taskpool_spawn(sortpool, pmsort, &left, &pending);
+    pmsort(&right);
+    taskpool_wait(sortpool, &pending);
+    pmerge_task_t merge = {t->todst ? t->src : t->dst, t->l, m, m + 1, t->r,
+                           t->todst ? t->dst : t->src, t->l};
+    pmerge(&merge);
+}
+
+void parallelmergesort(const int n, int x[]){
+    if (sortpool == NULL) sortpool = taskpool_create(sysconf(_SC_NPROCESSORS_ONLN));
+    int *b = (int*)malloc((n + 1) * sizeof(int));
+    if (b == NULL)
+    {
+        perror("Unable to allocate merge buffer");
+        exit(EXIT_FAILURE);
+    }
+    msort_task_t root = {x, b, 1, n, 0};
+    taskpool_run(sortpool, pmsort, &root);
+    free(b);
+}
+
+#ifdef DEBUG
+int check(const int n, int arr[]){
+    for (int i = 1; i < n; i++) if (arr[i] > arr[i+1]) return 1;
+    return 0;
+}
+#endif
+
+// Parallel sample sort on the same pool, for arrays so large that the
+// log2(n / PARALLEL_CUTOFF) merge passes of the parallel merge sort are bound
+// by memory bandwidth: here every key is moved only twice. Every
+// SAMPLE_OVERSAMPLING-th key of a sorted random sample becomes a splitter.
+// Each worker classifies its own block of x with a branchless descent of the
+// implicit splitter tree, remembering the class of every key, and scatters
+// the block by class into its own part of a scratch buffer. Those pages are
+// first written by that worker, so with first-touch allocation they land on
+// its NUMA node. Then each class gathers its pieces from all blocks into its
+// final place in x and is sorted there by introsort.
+// Every bucket has an equality bucket for the keys equal to its upper
+// splitter, which needs no sorting: with few unique keys the splitters repeat
+// and nearly all keys land in equality buckets, instead of one bucket that a
+// single worker would have to sort.
+#define SAMPLE_LOG_BUCKETS 8
+#define SAMPLE_BUCKETS (1 << SAMPLE_LOG_BUCKETS)
+#define SAMPLE_CLASSES (2 * SAMPLE_BUCKETS)
+#define SAMPLE_OVERSAMPLING 16
+#define SAMPLE_CUTOFF (1 << 16)
+
+typedef struct {
+    const int *x;           // x[lo..hi) of the 0-based input
+    int *tmp;
+    unsigned short *oracle; // class of every key
+    const int *tree, *upper;
+    int lo, hi;
+    int begin[SAMPLE_CLASSES + 1];  // class c at tmp[lo + begin[c]..lo + begin[c+1])
+} sample_block_t;
+
+typedef struct {
+    int *x;
+    const int *tmp;
+    const sample_block_t *block;
+    int blocks, c, start;   // class c goes to x[start..]
+} sample_bucket_t;
+
+typedef struct {
+    int *x, *tmp;
+    unsigned short *oracle;
+    const int *tree, *upper;
+    int n, blocks;
+} sample_root_t;
+
+// Bucket b of v: keys in (splitter b, splitter b + 1] with splitters sorted,
+// tree[1..SAMPLE_BUCKETS-1] in breadth-first order. Its class is 2 b, or
+// 2 b + 1 (the equality bucket) if v is splitter b + 1, upper[b].
+#define SAMPLE_DESCEND(j, v) (j) = 2 * (j) + ((v) > tree[j])
+#define SAMPLE_CLASS(j, v) (2 * ((j) - SAMPLE_BUCKETS) + ((v) == upper[(j) - SAMPLE_BUCKETS]))
+
+void sampleclassify(void *arg){
+    sample_block_t *t = (sample_block_t*)arg;
+    const int *x = t->x, *tree = t->tree, *upper = t->upper;
+    unsigned short *oracle = t->oracle;
+    int count[SAMPLE_CLASSES] = {0}, i = t->lo;
+    // Four independent descents at a time to hide the latency of each level
+    for ( ; i + 4 <= t->hi; i += 4)
+    {
+        int j0 = 1, j1 = 1, j2 = 1, j3 = 1;
+        for (int l = 0; l < SAMPLE_LOG_BUCKETS; l++)
+        {
+            SAMPLE_DESCEND(j0, x[i]); SAMPLE_DESCEND(j1, x[i+1]);
+            SAMPLE_DESCEND(j2, x[i+2]); SAMPLE_DESCEND(j3, x[i+3]);
+        }
+        int c0 = SAMPLE_CLASS(j0, x[i]), c1 = SAMPLE_CLASS(j1, x[i+1]);
+        int c2 = SAMPLE_CLASS(j2, x[i+2]), c3 = SAMPLE_CLASS(j3, x[i+3]);
+        oracle[i] = c0; oracle[i+1] = c1; oracle[i+2] = c2; oracle[i+3] = c3;
+        count[c0]++; count[c1]++; count[c2]++; count[c3]++;
+    }
+    for ( ; i < t->hi; i++)
+    {
+        int j = 1;
+        for (int l = 0; l < SAMPLE_LOG_BUCKETS; l++) SAMPLE_DESCEND(j, x[i]);
+        oracle[i] = SAMPLE_CLASS(j, x[i]);
+        count[oracle[i]]++;
+    }
+    int next[SAMPLE_CLASSES];
+    t->begin[0] = 0;
+    for (int c = 0; c < SAMPLE_CLASSES; c++)
+    {
+        next[c] = t->lo + t->begin[c];
+        t->begin[c + 1] = t->begin[c] + count[c];
+    }
+    for (i = t->lo; i < t->hi; i++) t->tmp[next[oracle[i]]++] = x[i];
+}
+
+void samplebucket(void *arg){
+    sample_bucket_t *t = (sample_bucket_t*)arg;
+    int pos = t->start;
+    for (int k = 0; k < t->blocks; k++)
+    {
+        const sample_block_t *blk = &t->block[k];
+        int len = blk->begin[t->c + 1] - blk->begin[t->c];
+        memcpy(t->x + pos, t->tmp + blk->lo + blk->begin[t->c], len * sizeof(int));
+        pos += len;
+    }
+    // The keys of an equality bucket are all equal
+    if (!(t->c & 1)) introsort(pos - t->start, t->x + t->start - 1);
+}
+
+void sampleroot(void *arg){
+    sample_root_t *r = (sample_root_t*)arg;
+    sample_block_t *block = (sample_block_t*)malloc(r->blocks * sizeof(sample_block_t));
+    sample_bucket_t *bucket = (sample_bucket_t*)malloc(SAMPLE_CLASSES * sizeof(sample_bucket_t));
+    if (block == NULL || bucket == NULL)
+    {
+        perror("Unable to allocate sample sort blocks");
+        exit(EXIT_FAILURE);
+    }
+    atomic_int pending = 0;
+    for (int k = 0; k < r->blocks; k++)
+    {
+        block[k] = (sample_block_t){.x = r->x, .tmp = r->tmp, .oracle = r->oracle,
+                                    .tree = r->tree, .upper = r->upper,
+                                    .lo = (int)((long long)r->n * k / r->blocks),
+                                    .hi = (int)((long long)r->n * (k + 1) / r->blocks)};
+        taskpool_spawn(sortpool, sampleclassify, &block[k], &pending);
+    }
+    taskpool_wait(sortpool, &pending);
+
+    for (int c = 0, start = 0; c < SAMPLE_CLASSES; c++)
+    {
+        bucket[c] = (sample_bucket_t){.x = r->x, .tmp = r->tmp, .block = block, .blocks = r->blocks,
+                                      .c = c, .start = start};
+        int len = 0;
+        for (int k = 0; k < r->blocks; k++) len += block[k].begin[c + 1] - block[k].begin[c];
+        if (len > 0) taskpool_spawn(sortpool, samplebucket, &bucket[c], &pending);
+        start += len;
+    }
+    taskpool_wait(sortpool, &pending);
+    free(block);
+    free(bucket);
+}
+
+void samplesort(const int n, int x[]){
+    if (n < SAMPLE_CUTOFF)
+    {
+        introsort(n, x);
+        return;
+    }
+    if (sortpool == NULL) sortpool = taskpool_create(sysconf(_SC_NPROCESSORS_ONLN));
+
+    // Splitters from a sorted random sample, laid out as a search tree, and
+    // the upper splitter of every bucket (INT_MAX for the last one, whose
+    // equality bucket then holds the keys equal to INT_MAX)
+    int sample[SAMPLE_BUCKETS * SAMPLE_OVERSAMPLING + 1], tree[SAMPLE_BUCKETS], upper[SAMPLE_BUCKETS];
+    for (int i = 1; i <= SAMPLE_BUCKETS * SAMPLE_OVERSAMPLING; i++)
+        sample[i] = x[(int)(((unsigned long long)rand() * n) / ((unsigned long long)RAND_MAX + 1)) + 1];
+    introsort(SAMPLE_BUCKETS * SAMPLE_OVERSAMPLING, sample);
+    for (int j = 1; j < SAMPLE_BUCKETS; j++)
+    {
+        int level = 31 - __builtin_clz(j), p = j - (1 << level);
+        tree[j] = sample[(2 * p + 1) * (SAMPLE_BUCKETS >> (level + 1)) * SAMPLE_OVERSAMPLING];
+    }
+    for (int b = 0; b < SAMPLE_BUCKETS - 1; b++) upper[b] = sample[(b + 1) * SAMPLE_OVERSAMPLING];
+    upper[SAMPLE_BUCKETS - 1] = INT_MAX;
+
+    // Not touched here, so the pages are placed by the workers that fill them
+    int *tmp = (int*)malloc((size_t)n * sizeof(int));
+    unsigned short *oracle = (unsigned short*)malloc((size_t)n * sizeof(unsigned short));
+    if (tmp == NULL || oracle == NULL)
+    {
+        perror("Unable to allocate sample sort buffers");
+        exit(EXIT_FAILURE);
+    }
+    sample_root_t root = {x + 1, tmp, oracle, tree, upper, n, sortpool->threads};
+    taskpool_run(sortpool, sampleroot, &root);
+    free(tmp);
+    free(oracle);
+#ifdef DEBUG
+    if (check(n, x))
+    {
+        fprintf(stderr, "samplesort: output is not sorted\n");
+        exit(EXIT_FAILURE);
+    }
+#endif
+}
+
+// Adapters to the (n, x[]) form used by the benchmark.
+void quicksortall(const int n, int x[]){ quicksort(x, 1, n); }
+void nonrecursivequicksortall(const int n, int x[]){ nonrecursivequicksort(n, x); }
+void mergesortall(const int n, int x[]){ mergesort(x, 1, n); }
+
+
+// Every method of the benchmark with the largest size it is run at: the
+// quadratic sorts stop at 10^5 and mergesort at 2^20, where the VLA in merge()
+// gets close to the default stack limit.
+typedef struct {
+    char name[20];
+    void (*sort)(const int n, int x[]);
+    int maxsize;
+} sortingmethod_t;
+
+const sortingmethod_t sortingmethod[] = {
+    {"Insertion", insertionsort, 100000},
+    {"Binary Insertion", binaryinsertionsort, 100000},
+    {"Selection", selectionsort, 100000},
+    {"Quick", quicksortall, 2147483647},
+    {"Non-recursive Quick", nonrecursivequicksortall, 2147483647},
+    {"Block Quick", blockquicksort, 2147483647},
+    {"Merge", mergesortall, 1 << 20},
+    {"Powersort", powersort, 2147483647},
+    {"Heap", heapsort, 2147483647},
+    {"Bottom-up Heap", bottomupheapsort, 2147483647},
+    {"4-ary Heap", quaternaryheapsort, 2147483647},
+    {"8-ary Heap", octonaryheapsort, 2147483647},
+    {"Parallel Merge", parallelmergesort, 2147483647},
+    {"Sample", samplesort, 2147483647},
+    {"Introsort", introsort, 2147483647},
+    {"LSD Radix", lsdradixsort, 2147483647},
+    {"American Flag", americanflagsort, 2147483647},
+};
+#define METHODS ((int)(sizeof(sortingmethod) / sizeof(sortingmethod[0])))
+
+void usage(const char *program){
+    printf("Usage: %s [-n sizes] [-d distributions] [-m methods] [-r reps] [-w warmups]\n"
+           "          [-s seed] [-o csvfile] [-j jsonfile]\n\n", program);
+    printf("  -n  comma separated array sizes (default 1000,10000,100000,1000000)\n");
+    printf("  -d  comma separated distributions (default all):");
+    for (int i = 0; i < DISTRIBUTIONS; i++) printf(" %s", distributionname[i]);
+    printf("\n  -m  comma separated methods (default all):");
+    for (int i = 0; i < METHODS; i++) printf(" \"%s\"", sortingmethod[i].name);
+    printf("\n  -r  timed repetitions per case (default 5)\n");
+    printf("  -w  untimed warmup runs per case (default 1)\n");
+    printf("  -o  CSV result file (default mytable.csv)\n");
+    printf("  -j  JSON result file (default none)\n\n");
+    printf("       %s generate file n [distribution]\n", program);
+    printf("  write n ints of the distribution (default random) to a binary file\n\n");
+    printf("       %s external input output [memoryMB [tmpdir]]\n", program);
+    printf("  sort a binary file of ints larger than memory (default 256 MB, $TMPDIR or /tmp)\n\n");
+    printf("       %s select [n [distribution [reps]]]\n", program);
+    printf("  time introselect, partialsort and top-k against a full sort for several k\n\n");
+    printf("       %s generic [n [reps]]\n", program);
+    printf("  time the gensort.h sorts on int32, int64, double and 16-byte records\n\n");
+    printf("       %s records [n [reps]]\n", program);
+    printf("  time sorting n records of 64 to 256 bytes directly and through a permutation\n\n");
+    printf("       %s topk input k\n", program);
+    printf("  print the k smallest ints of a binary file in one pass\n");
+}
+
+// Write n keys of the distribution to a binary file, in blocks.
+int generatefile(const char *path, const long long n, const int dist){
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL){
+        perror("Unable to open output file");
+        return 1;
+    }
+    const int block = 1 << 22;
+    int *x = (int*)malloc((block + 1) * sizeof(int));
+    if (x == NULL){
+        perror("Unable to allocate block");
+        return 1;
+    }
+    bench_seed(n);
+    for (long long done = 0; done < n; done += block){
+        int m = (n - done < block) ? (int)(n - done) : block;
+        generate(dist, m, x);
+        if (dist == SORTED || dist == NEARLYSORTED)
+            for (int j = 1; j <= m; j++) x[j] += (int)done;
+        else if (dist == REVERSED)
+            for (int j = 1; j <= m; j++) x[j] = (int)(n - done - j + 1);
+        if (fwrite(x + 1, sizeof(int), m, fp) != (size_t)m){
+            perror("Error writing output file");
+            free(x);
+            fclose(fp);
+            return 1;
+        }
+    }
+    free(x);
+    if (fclose(fp) != 0){
+        perror("Error writing output file");
+        return 1;
+    }
+    return 0;
+}
+
+// Median time of introselect, partialsort, the top-k heap and a full
+// introsort for the k smallest of n keys, over a range of k.
+int selectbenchmark(const int n, const int dist, const int reps){
+    const char name[4][12] = {"introselect", "partialsort", "topk", "introsort"};
+    int ks[] = {1, 10, 100, 1000, n / 100, n / 10, n / 2, n};
+    int *input = (int*)malloc((n + 1) * sizeof(int));
+    int *arr = (int*)malloc((n + 1) * sizeof(int));
+    int *out = (int*)malloc((n + 1) * sizeof(int));
+    double *times = (double*)malloc(reps * sizeof(double));
+    if (input == NULL || arr == NULL || out == NULL || times == NULL){
+        perror("Unable to allocate arrays");
+        return 1;
+    }
+    bench_seed(n);
+    generate(dist, n, input);
+#ifdef DEBUG
+    int *sorted = (int*)malloc((n + 1) * sizeof(int));
+    memcpy(sorted, input, (n + 1) * sizeof(int));
+    introsort(n, sorted);
+#endif
+    printf("%s input of size %d, median of %d runs (s)\n", distributionname[dist], n, reps);
+    printf("%11s %12s %12s %12s %12s\n", "k", name[0], name[1], name[2], name[3]);
+    for (int c = 0, last = 0; c < (int)(sizeof(ks) / sizeof(ks[0])); c++){
+        int k = ks[c];
+        if (k <= last || k > n) continue;
+        last = k;
+        printf("%11d", k);
+        for (int m = 0; m < 4; m++){
+            for (int r = 0; r < reps; r++){
+                memcpy(arr, input, (n + 1) * sizeof(int));
+                double start = bench_now();
+                switch (m){
+                case 0: introselect(n, arr, k); break;
+                case 1: partialsort(n, arr, k); break;
+                case 2:{
+                    topk_t *t = topk_create(k);
+                    topk_push(t, n, arr + 1);
+                    topk_result(t, out);
+                    topk_free(t);
+                    break;
+                }
+                case 3: introsort(n, arr); break;
+                }
+                times[r] = bench_now() - start;
+#ifdef DEBUG
+                int bad = (arr[k] != sorted[k]);
+                if (m == 1) bad |= memcmp(arr + 1, sorted + 1, k * sizeof(int)) != 0;
+                if (m == 2) bad = memcmp(out + 1, sorted + 1, k * sizeof(int)) != 0;
+                if (bad){
+                    printf("\nError: %s for k = %d\n", name[m], k);
+                    return -1;
+                }
+#endif
+            }
+            printf(" %12.6f", stats_compute(times, reps).median);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+#ifdef DEBUG
+    free(sorted);
+#endif
+    free(input);
+    free(arr);
+    free(out);
+    free(times);
+    return 0;
+}
+
+static int compare_record4(const void *a, const void *b){
+    int32_t x, y;
+    memcpy(&x, a, 4); memcpy(&y, b, 4);
+    return (x > y) - (x < y);
+}
+
+static int compare_record8(const void *a, const void *b){
+    int64_t x, y;
+    memcpy(&x, a, 8); memcpy(&y, b, 8);
+    return (x > y) - (x < y);
+}
+
+// Median time to order n records of 64 to 256 bytes with a random 4- or
+// 8-byte key at their start: qsort moving the records, the permutation
+// alone, the permutation applied in place, and the permutation gathered
+// into a second array.
+int recordbenchmark(const int n, const int reps){
+    const int widths[3] = {64, 128, 256}, keysizes[2] = {4, 8};
+    const char name[4][12] = {"qsort", "permutation", "inplace", "gather"};
+    char *input = (char*)malloc((size_t)n * 256 + 1), *rec = (char*)malloc((size_t)n * 256 + 1);
+    char *out = (char*)malloc((size_t)n * 256 + 1);
+    double *times = (double*)malloc(reps * sizeof(double));
+    if (input == NULL || rec == NULL || out == NULL || times == NULL){
+        perror("Unable to allocate records");
+        return 1;
+    }
+    printf("%d records, median of %d runs (s)\n", n, reps);
+    printf("%6s %8s %12s %12s %12s %12s\n", "width", "keysize", name[0], name[1], name[2], name[3]);
+    for (int w = 0; w < 3; w++)
+        for (int ks = 0; ks < 2; ks++){
+            const size_t width = widths[w];
+            const int keysize = keysizes[ks];
+            // Key first, the rest of the record a byte pattern of the key
+            bench_seed(n ^ width);
+            for (int i = 0; i < n; i++){
+                char *r = input + (size_t)i * width;
+                uint64_t v = bench_rand();
+                memcpy(r, &v, keysize);
+                memset(r + keysize, (int)(v & 0xFF), width - keysize);
+            }
+            printf("%6d %8d", (int)width, keysize);
+            for (int m = 0; m < 4; m++){
+                for (int t = 0; t < reps; t++){
+                    memcpy(rec, input, (size_t)n * width);
+                    char *sorted = rec;
+                    double start = bench_now();
+                    if (m == 0) qsort(rec, n, width, keysize == 4 ? compare_record4 : compare_record8);
+                    else if (m == 2) recordsort(rec, n, width, 0, keysize);
+                    else {
+                        int *perm = recordpermutation(rec, n, width, 0, keysize);
+                        if (m == 3){
+                            for (int i = 0; i < n; i++)
+                                memcpy(out + (size_t)i * width, rec + (size_t)perm[i] * width, width);
+                            sorted = out;
+                        }
+                        free(perm);
+                    }
+                    times[t] = bench_now() - start;
+#ifdef DEBUG
+                    for (int i = 0; m != 1 && i < n; i++){
+                        const char *r = sorted + (size_t)i * width;
+                        int bad = (i > 0 && (keysize == 4 ? compare_record4 : compare_record8)(r - width, r) > 0);
+                        for (size_t b = keysize; b < width; b++) bad |= (r[b] != r[0]);
+                        if (bad){
+                            printf("\nError: %s at record %d\n", name[m], i);
+                            return -1;
+                        }
+                    }
+#endif
+                    (void)sorted;
+                }
+                printf(" %12.6f", stats_compute(times, reps).median);
+                fflush(stdout);
+            }
+            printf("\n");
+        }
+    free(input);
+    free(rec);
+    free(out);
+    free(times);
+    return 0;
+}
+
+#define GENERIC_ALGORITHMS 8
+#define GENERIC_TYPES 4
+
+const char genericname[GENERIC_ALGORITHMS][20] = {"Insertion", "Binary Insertion", "Selection", "Quick",
+                                                  "Non-recursive Quick", "Merge", "Heap", "sort"};
+
+// Order-independent fingerprint of n elements of size bytes: the sum of a
+// hash of every element, equal for any permutation of the same elements.
+uint64_t generic_fingerprint(const void *p, const int n, const size_t size){
+    const unsigned char *c = (const unsigned char*)p;
+    uint64_t sum = 0;
+    for (int i = 0; i < n; i++){
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (size_t b = 0; b < size; b++, c++) h = (h ^ *c) * 0x100000001b3ULL;
+        h ^= h >> 29; h *= 0xbf58476d1ce4e5b9ULL; h ^= h >> 32;
+        sum += h;
+    }
+    return sum;
+}
+
+// Median times of the gensort.h sorts of one type into time[][column],
+// NAN where the quadratic sorts are skipped. Every output must be sorted and
+// a permutation of the input.
+#define GENERIC_BENCHMARK(suffix, type, LESS, input, n, reps, column, time)                        \
+{                                                                                                   \
+    void (*fn[GENERIC_ALGORITHMS])(const int, type[]) = {insertionsort##suffix,                     \
+        binaryinsertionsort##suffix, selectionsort##suffix, quicksort##suffix,                      \
+        nonrecursivequicksort##suffix, mergesort##suffix, heapsort##suffix, sort##suffix};          \
+    type *arr = (type*)malloc((n + 1) * sizeof(type));                                              \
+    double *runs = (double*)malloc(reps * sizeof(double));                                          \
+    if (arr == NULL || runs == NULL){                                                               \
+        perror("Unable to allocate arrays");                                                        \
+        exit(EXIT_FAILURE);                                                                         \
+    }                                                                                               \
+    const uint64_t fingerprint = generic_fingerprint(input + 1, n, sizeof(type));                   \
+    for (int a = 0; a < GENERIC_ALGORITHMS; a++){                                                   \
+        time[a][column] = NAN;                                                                      \
+        if (a < 3 && n > 100000) continue;                                                          \
+        for (int r = 0; r < reps; r++){                                                             \
+            memcpy(arr, input, (n + 1) * sizeof(type));                                             \
+            double start = bench_now();                                                             \
+            fn[a](n, arr);                                                                          \
+            runs[r] = bench_now() - start;                                                          \
+            for (int i = 1; i < n; i++)                                                             \
+                if (LESS(arr[i + 1], arr[i])){                                                      \
+                    printf("Error: %s on " #type " at %d\n", genericname[a], i);                    \
+                    exit(EXIT_FAILURE);                                                             \
+                }                                                                                   \
+            if (generic_fingerprint(arr + 1, n, sizeof(type)) != fingerprint){                      \
+                printf("Error: %s on " #type " lost keys\n", genericname[a]);                       \
+                exit(EXIT_FAILURE);                                                                 \
+            }                                                                                       \
+        }                                                                                           \
+        time[a][column] = stats_compute(runs, reps).median;                                         \
+    }                                                                                               \
+    free(arr);                                                                                      \
+    free(runs);                                                                                     \
+}
+
+// Time the generic sorts on int32, int64, double and 16-byte records, checking
+// that every output is sorted and a permutation of its input, and that the
+// merge and radix sorts of the records are stable.
+int genericbenchmark(const int n, const int reps){
+    int *i32 = (int*)malloc((n + 1) * sizeof(int));
+    long long *i64 = (long long*)malloc((n + 1) * sizeof(long long));
+    double *f64 = (double*)malloc((n + 1) * sizeof(double));
+    pair_t *pair = (pair_t*)malloc((n + 1) * sizeof(pair_t));
+    if (i32 == NULL || i64 == NULL || f64 == NULL || pair == NULL){
+        perror("Unable to allocate arrays");
+        return 1;
+    }
+    bench_seed(n);
+    for (int i = 1; i <= n; i++){
+        uint64_t v = bench_rand();
+        i32[i] = (int)(v >> 32);
+        i64[i] = (long long)v;
+        f64[i] = (double)(v >> 11) * (1.0 / 9007199254740992.0) - 0.5;
+        pair[i].key = (long long)(v >> 40);     // ties, to exercise the stable sorts
+        pair[i].value = i;
+    }
+
+    double time[GENERIC_ALGORITHMS][GENERIC_TYPES];
+    GENERIC_BENCHMARK(_int32, int, LESS_VALUE, i32, n, reps, 0, time)
+    GENERIC_BENCHMARK(_int64, long long, LESS_VALUE, i64, n, reps, 1, time)
+    GENERIC_BENCHMARK(_double, double, LESS_VALUE, f64, n, reps, 2, time)
+    GENERIC_BENCHMARK(_pair, pair_t, LESS_PAIR, pair, n, reps, 3, time)
+    printf("%d keys, median of %d runs (s); sort is radix for the integral keys, quick for double\n", n, reps);
+    printf("%-20s %12s %12s %12s %12s\n", "method", "int32", "int64", "double", "pair16");
+    for (int k = 0; k < GENERIC_ALGORITHMS; k++){
+        printf("%-20s", genericname[k]);
+        for (int c = 0; c < GENERIC_TYPES; c++)
+            if (isnan(time[k][c])) printf(" %12s", "-");
+            else printf(" %12.6f", time[k][c]);
+        printf("\n");
+    }
+
+    // Stability of the merge and radix sorts on the keys with ties
+    pair_t *p = (pair_t*)malloc((n + 1) * sizeof(pair_t));
+    for (int k = 0; k < 2; k++){
+        memcpy(p, pair, (n + 1) * sizeof(pair_t));
+        if (k == 0) mergesort_pair(n, p); else radixsort_pair(n, p);
+        for (int i = 1; i < n; i++)
+            if (p[i].key == p[i + 1].key && p[i].value > p[i + 1].value){
+                printf("Error: %s sort of pairs is not stable\n", k ? "radix" : "merge");
+                return -1;
+            }
+    }
+    free(p);
+    free(i32);
+    free(i64);
+    free(f64);
+    free(pair);
+    return 0;
+}
+
+// Print the k smallest ints of a binary file, reading it once in blocks.
+int topkfile(const char *path, const int k){
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL){
+        perror("Unable to open input file");
+        return 1;
+    }
+    const int block = 1 << 16;
+    int *x = (int*)malloc(block * sizeof(int));
+    int *out = (int*)malloc((k + 1) * sizeof(int));
+    if (x == NULL || out == NULL){
+        perror("Unable to allocate block");
+        return 1;
+    }
+    topk_t *t = topk_create(k);
+    size_t m;
+    while ((m = fread(x, sizeof(int), block, fp)) > 0) topk_push(t, (int)m, x);
     fclose(fp);
+    int count = topk_result(t, out);
+    for (int i = 1; i <= count; i++) printf("%d\n", out[i]);
+    topk_free(t);
+    free(x);
+    free(out);
+    return 0;
+}
+
+int main(int argc, char *argv[]){
+    int sizes[64] = {1000, 10000, 100000, 1000000}, nsizes = 4;
+    int usedist[DISTRIBUTIONS], usemethod[METHODS];
+    int reps = 5, warmups = 1;
+    unsigned long long seed = 1;
+    const char *csvfile = "mytable.csv", *jsonfile = NULL;
+    for (int i = 0; i < DISTRIBUTIONS; i++) usedist[i] = 1;
+    for (int i = 0; i < METHODS; i++) usemethod[i] = 1;
+
+    if (argc > 3 && strcmp(argv[1], "generate") == 0){
+        int dist = RANDOM;
+        if (argc > 4)
+            for (int i = 0; i < DISTRIBUTIONS; i++) if (namematch(argv[4], distributionname[i])) dist = i;
+        return generatefile(argv[2], (long long)strtod(argv[3], NULL), dist);
+    }
+    if (argc > 1 && strcmp(argv[1], "select") == 0){
+        int dist = RANDOM;
+        if (argc > 3)
+            for (int i = 0; i < DISTRIBUTIONS; i++) if (namematch(argv[3], distributionname[i])) dist = i;
+        int n = (argc > 2) ? (int)strtod(argv[2], NULL) : 10000000, r = (argc > 4) ? atoi(argv[4]) : 5;
+        return selectbenchmark(n < 1 ? 1 : n, dist, r < 1 ? 1 : r);
+    }
+    if (argc > 1 && strcmp(argv[1], "generic") == 0){
+        int n = (argc > 2) ? (int)strtod(argv[2], NULL) : 1000000, r = (argc > 3) ? atoi(argv[3]) : 5;
+        return genericbenchmark(n < 1 ? 1 : n, r < 1 ? 1 : r);
+    }
+    if (argc > 1 && strcmp(argv[1], "records") == 0){
+        int n = (argc > 2) ? (int)strtod(argv[2], NULL) : 1000000, r = (argc > 3) ? atoi(argv[3]) : 5;
+        return recordbenchmark(n < 1 ? 1 : n, r < 1 ? 1 : r);
+    }
+    if (argc > 3 && strcmp(argv[1], "topk") == 0){
+        int k = atoi(argv[3]);
+        if (k < 1){
+            fprintf(stderr, "k must be positive\n");
+            return 1;
+        }
+        return topkfile(argv[2], k);
+    }
+    if (argc > 3 && strcmp(argv[1], "external") == 0){
+        size_t memory = (size_t)(((argc > 4) ? atof(argv[4]) : 256) * (1 << 20));
+        const char *tmpdir = (argc > 5) ? argv[5] : getenv("TMPDIR");
+        if (tmpdir == NULL) tmpdir = "/tmp";
+        // LSD radix is the fastest in-memory method and needs one int of scratch per key
+        external_t stat = externalsort(argv[2], argv[3], memory, lsdradixsort, sizeof(int), tmpdir);
+        double mb = stat.bytes / (1 << 20);
+        printf("%.1f MB in %d runs, %d merge passes\n", mb, stat.runs, stat.passes);
+        printf("run formation %.3f s (%.1f MB/s), merge %.3f s (%.1f MB/s), total %.1f MB/s\n",
+               stat.formation, mb / stat.formation, stat.merge, mb / stat.merge,
+               mb / (stat.formation + stat.merge));
+        return 0;
+    }
+
+    for (int a = 1; a < argc; a++){
+        if (argv[a][0] != '-' || argv[a][1] == '\0' || argv[a][2] != '\0' || a + 1 >= argc){
+            usage(argv[0]);
+            return 1;
+        }
+        char *value = argv[++a];
+        switch (argv[a-1][1]){
+        case 'n':
+            nsizes = 0;
+            for (char *tok = strtok(value, ","); tok && nsizes < 64; tok = strtok(NULL, ","))
+                sizes[nsizes++] = (int)strtod(tok, NULL);   // accepts 1e6
+            break;
+        case 'd':
+        case 'm':{
+            int isdist = (argv[a-1][1] == 'd'), total = isdist ? DISTRIBUTIONS : METHODS;
+            int *use = isdist ? usedist : usemethod;
+            for (int i = 0; i < total; i++) use[i] = 0;
+            for (char *tok = strtok(value, ","); tok; tok = strtok(NULL, ",")){
+                int found = 0;
+                for (int i = 0; i < total; i++)
+                    if (namematch(tok, isdist ? distributionname[i] : sortingmethod[i].name)) use[i] = found = 1;
+                if (!found){
+                    fprintf(stderr, "Unknown %s %s\n", isdist ? "distribution" : "method", tok);
+                    return 1;
+                }
+            }
+            break;
+        }
+        case 'r': reps = atoi(value); break;
+        case 'w': warmups = atoi(value); break;
+        case 's': seed = strtoull(value, NULL, 10); break;
+        case 'o': csvfile = value; break;
+        case 'j': jsonfile = value; break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (reps < 1) reps = 1;
+
+    result_t *result = (result_t*)malloc(nsizes * DISTRIBUTIONS * METHODS * sizeof(result_t));
+    double *times = (double*)malloc(reps * sizeof(double));
+    double *cputimes = (double*)malloc(reps * sizeof(double));
+    double *counts = (double*)malloc(reps * PERF_EVENTS * sizeof(double));
+    if (result == NULL || times == NULL || cputimes == NULL || counts == NULL){
+        perror("Unable to allocate result table");
+        return 1;
+    }
+    int count = 0;
+
+    perfcounter_t pc;
+    if (perf_open(&pc) == 0)
+        fprintf(stderr, "Hardware counters unavailable, reporting timings only\n");
+
+    printf("%-20s %-13s %11s %12s %12s %12s %12s", "method", "distribution", "size", "median", "p10", "p90", "cpu");
+    if (pc.available)
+        printf(" %6s %9s %9s %9s %9s", "IPC", "brmiss/n", "L1miss/n", "LLCmiss/n", "TLBmiss/n");
+    printf("\n");
+    for (int s = 0; s < nsizes; s++){
+        int arr_size = sizes[s];
+        int *input = (int*)malloc((arr_size + 1) * sizeof(int));
+        int *arr = (int*)malloc((arr_size + 1) * sizeof(int));
+        if (input == NULL || arr == NULL){
+            perror("Unable to allocate input arrays");
+            return 1;
+        }
+        for (int d = 0; d < DISTRIBUTIONS; d++){
+            if (!usedist[d]) continue;
+            bench_seed(seed ^ ((unsigned long long)arr_size << 8) ^ d);
+            generate(d, arr_size, input);
+            for (int i = 0; i < METHODS; i++){
+                if (!usemethod[i] || arr_size > sortingmethod[i].maxsize) continue;
+                for (int r = -warmups; r < reps; r++){
+                    memcpy(arr, input, (arr_size + 1) * sizeof(int));
+                    double sample[PERF_EVENTS];
+                    perf_start(&pc);
+                    double start = bench_now(), cpustart = bench_cputime();
+                    sortingmethod[i].sort(arr_size, arr);
+                    double end = bench_now(), cpuend = bench_cputime();
+                    perf_stop(&pc, sample);
+                    if (r >= 0){
+                        times[r] = end - start;
+                        cputimes[r] = cpuend - cpustart;
+                        memcpy(counts + r * PERF_EVENTS, sample, sizeof(sample));
+                    }
+#ifdef DEBUG
+                    if(check(arr_size, arr)){
+                        printf("Error: %s sort on %s input of size %d\n", sortingmethod[i].name,
+                               distributionname[d], arr_size);
+                        return -1;
+                    }
+#endif
+                }
+                result_t *res = &result[count++];
+                res->method = sortingmethod[i].name;
+                res->distribution = distributionname[d];
+                res->n = arr_size;
+                res->reps = reps;
+                res->time = stats_compute(times, reps);
+                res->cputime = stats_compute(cputimes, reps).median;
+                for (int e = 0; e < PERF_EVENTS; e++){
+                    for (int r = 0; r < reps; r++) times[r] = counts[r * PERF_EVENTS + e];
+                    res->counter[e] = stats_compute(times, reps).median;
+                }
+                printf("%-20s %-13s %11d %12.6f %12.6f %12.6f %12.6f", res->method, res->distribution,
+                       arr_size, res->time.median, res->time.p10, res->time.p90, res->cputime);
+                if (pc.available)
+                    printf(" %6.2f %9.3f %9.3f %9.3f %9.3f",
+                           res->counter[PERF_INSTRUCTIONS] / res->counter[PERF_CYCLES],
+                           res->counter[PERF_BRANCHMISSES] / arr_size, res->counter[PERF_L1MISSES] / arr_size,
+                           res->counter[PERF_LLCMISSES] / arr_size, res->counter[PERF_TLBMISSES] / arr_size);
+                printf("\n");
+                fflush(stdout);
+            }
+        }
+        free(input);
+        free(arr);
+    }
+
+    FILE * fp;
+    if (csvfile != NULL && (fp = fopen(csvfile, "w")) != NULL){
+        write_csv(fp, result, count);
+        fclose(fp);
+    }
+    if (jsonfile != NULL && (fp = fopen(jsonfile, "w")) != NULL){
+        write_json(fp, result, count);
+        fclose(fp);
+    }
+    perf_close(&pc);
+    free(result);
+    free(times);
+    free(cputimes);
+    free(counts);
+    if (sortpool != NULL) taskpool_destroy(sortpool);
 
     return 0;
 }
@@ -0,0 +1,221 @@
+/* Benchmark support for the sorting methods: input distributions, a monotonic
+   clock and CPU time, order statistics of repeated runs and CSV/JSON result
+   files, with the hardware counters of perfcounter.h when available. */
+
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "perfcounter.h"
+
+/* Input distributions */
+enum distribution {RANDOM, SORTED, REVERSED, FEWUNIQUE, ORGANPIPE, ZIPF, NEARLYSORTED, RUNS, DISTRIBUTIONS};
+
+const char distributionname[DISTRIBUTIONS][16] = {"random", "sorted", "reversed", "fewunique", "organpipe",
+                                                  "zipf", "nearlysorted", "runs"};
+
+/* Number of sorted batches of the RUNS distribution */
+#define BENCH_RUNS 16
+
+/* xorshift64*, rand() is too short and too slow for 10^9 keys */
+static uint64_t bench_state = 88172645463325252ULL;
+
+void bench_seed(const uint64_t seed)
+{
+    bench_state = seed * 0x9E3779B97F4A7C15ULL + 1;
+}
+
+static inline uint64_t bench_rand(void)
+{
+    bench_state ^= bench_state >> 12;
+    bench_state ^= bench_state << 25;
+    bench_state ^= bench_state >> 27;
+    return bench_state * 0x2545F4914F6CDD1DULL;
+}
+
+/* Uniform in [0, m) */
+static inline int bench_uniform(const int m)
+{
+    return (int)(((bench_rand() >> 32) * (uint64_t)m) >> 32);
+}
+
+/* Fill x[1..n] with keys of the given distribution */
+void generate(const int dist, const int n, int x[])
+{
+    switch (dist)
+    {
+    case RANDOM:    /* a shuffled permutation of 1..n */
+        for (int j = 1; j <= n; j++) x[j] = j;
+        for (int j = n; j > 1; j--)
+        {
+            int k = bench_uniform(j) + 1;
+            int t = x[j]; x[j] = x[k]; x[k] = t;
+        }
+        break;
+    case SORTED:
+        for (int j = 1; j <= n; j++) x[j] = j;
+        break;
+    case REVERSED:
+        for (int j = 1; j <= n; j++) x[j] = n - j + 1;
+        break;
+    case FEWUNIQUE:  /* 16 distinct keys */
+        for (int j = 1; j <= n; j++) x[j] = bench_uniform(16);
+        break;
+    case ORGANPIPE:  /* ascending then descending */
+        for (int j = 1; j <= n; j++) x[j] = (j <= n / 2) ? j : n - j + 1;
+        break;
+    case ZIPF:       /* key k with probability about 1/k, by inverting the continuous CDF */
+        {
+            double logn = log((double)n + 1);
+            for (int j = 1; j <= n; j++)
+                x[j] = (int)exp(logn * (bench_rand() >> 11) * (1.0 / 9007199254740992.0));
+        }
+        break;
+    case NEARLYSORTED:  /* sorted with 1% of the keys swapped at random */
+        for (int j = 1; j <= n; j++) x[j] = j;
+        for (int j = 0; j < n / 100; j++)
+        {
+            int a = bench_uniform(n) + 1, b = bench_uniform(n) + 1;
+            int t = x[a]; x[a] = x[b]; x[b] = t;
+        }
+        break;
+    case RUNS:          /* BENCH_RUNS ascending batches over overlapping ranges, concatenated */
+        for (int r = 0; r < BENCH_RUNS; r++)
+        {
+            int v = bench_uniform(n);
+            for (int j = (int)((long long)n * r / BENCH_RUNS) + 1; j <= (long long)n * (r + 1) / BENCH_RUNS; j++)
+                x[j] = v += bench_uniform(3);
+        }
+        break;
+    }
+}
+
+/* Seconds on the monotonic clock */
+static inline double bench_now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* Seconds of CPU time used by all threads of the process */
+static inline double bench_cputime(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    double min, p10, median, p90, max, mean;
+} stats_t;
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile q of the sorted times t[0..r-1] */
+static inline double percentile(const double t[], const int r, const double q)
+{
+    int k = (int)ceil(q * r) - 1;
+    return t[k < 0 ? 0 : k];
+}
+
+/* Order statistics of r run times (t is sorted in place). NaN samples, such
+   as a counter read that failed in one repetition, are left out; if there is
+   no other sample every statistic is NaN. */
+stats_t stats_compute(double t[], int r)
+{
+    stats_t s;
+    int k = 0;
+    for (int i = 0; i < r; i++)
+        if (!isnan(t[i])) t[k++] = t[i];
+    r = k;
+    if (r == 0)
+    {
+        s.min = s.p10 = s.median = s.p90 = s.max = s.mean = NAN;
+        return s;
+    }
+    qsort(t, r, sizeof(double), compare_double);
+    s.min = t[0];
+    s.p10 = percentile(t, r, 0.10);
+    s.median = (r % 2) ? t[r / 2] : (t[r / 2 - 1] + t[r / 2]) / 2;
+    s.p90 = percentile(t, r, 0.90);
+    s.max = t[r - 1];
+    s.mean = 0;
+    for (int i = 0; i < r; i++) s.mean += t[i];
+    s.mean /= r;
+    return s;
+}
+
+/* One line of the result files */
+typedef struct {
+    const char *method, *distribution;
+    int n, reps;
+    stats_t time;
+    double cputime;                 /* median CPU seconds */
+    double counter[PERF_EVENTS];    /* median counts, NAN if unavailable */
+} result_t;
+
+void write_csv(FILE *fp, const result_t result[], const int count)
+{
+    fprintf(fp, "algorithm,distribution,size,reps,min,p10,median,p90,max,mean,cputime");
+    for (int e = 0; e < PERF_EVENTS; e++) fprintf(fp, ",%s", perfname[e]);
+    fprintf(fp, "\n");
+    for (int i = 0; i < count; i++)
+    {
+        const result_t *r = &result[i];
+        fprintf(fp, "%s,%s,%d,%d,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f", r->method, r->distribution, r->n,
+                r->reps, r->time.min, r->time.p10, r->time.median, r->time.p90, r->time.max, r->time.mean,
+                r->cputime);
+        for (int e = 0; e < PERF_EVENTS; e++)    /* empty when unavailable */
+            if (isnan(r->counter[e])) fprintf(fp, ",");
+            else fprintf(fp, ",%.0f", r->counter[e]);
+        fprintf(fp, "\n");
+    }
+}
+
+void write_json(FILE *fp, const result_t result[], const int count)
+{
+    fprintf(fp, "[\n");
+    for (int i = 0; i < count; i++)
+    {
+        const result_t *r = &result[i];
+        fprintf(fp, "  {\"algorithm\": \"%s\", \"distribution\": \"%s\", \"size\": %d, \"reps\": %d, "
+                "\"min\": %.9f, \"p10\": %.9f, \"median\": %.9f, \"p90\": %.9f, \"max\": %.9f, \"mean\": %.9f, "
+                "\"cputime\": %.9f",
+                r->method, r->distribution, r->n, r->reps, r->time.min, r->time.p10, r->time.median,
+                r->time.p90, r->time.max, r->time.mean, r->cputime);
+        for (int e = 0; e < PERF_EVENTS; e++)
+            if (isnan(r->counter[e])) fprintf(fp, ", \"%s\": null", perfname[e]);
+            else fprintf(fp, ", \"%s\": %.0f", perfname[e], r->counter[e]);
+        fprintf(fp, "}%s\n", (i + 1 < count) ? "," : "");
+    }
+    fprintf(fp, "]\n");
+}
+
+/* Case-insensitive name comparison that ignores spaces, '-' and '_',
+   so "binary-insertion" selects "Binary Insertion". */
+int namematch(const char *a, const char *b)
+{
+    while (1)
+    {
+        while (*a == ' ' || *a == '-' || *a == '_') a++;
+        while (*b == ' ' || *b == '-' || *b == '_') b++;
+        char ca = (*a >= 'A' && *a <= 'Z') ? *a + 32 : *a;
+        char cb = (*b >= 'A' && *b <= 'Z') ? *b + 32 : *b;
+        if (ca != cb) return 0;
+        if (ca == '\0') return 1;
+        a++; b++;
+    }
+}
+
+#endif
@@ -0,0 +1,269 @@
+/* External sort of binary files of native ints that do not fit in memory.
+
+   Run formation reads the input in chunks that fit the memory budget, sorts
+   each chunk with the given in-memory method and writes it to an unlinked
+   temporary file. The runs are then combined by a k-way merge driven by a
+   loser (tournament) tree: the tree stores the loser of every match, so the
+   next key is found by replaying only the matches on the path of the run
+   that just advanced, log2 k comparisons per key. All run and output I/O goes
+   through large buffers carved from the same budget; if there are more runs
+   than buffers fit, runs are merged in several passes. */
+
+#ifndef __EXTERNALSORT_H__
+#define __EXTERNALSORT_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "benchmark.h"
+
+/* Smallest buffer per run during a merge */
+#define EXTERNAL_MIN_BUFFER (256 << 10)
+
+typedef struct {
+    double bytes;           /* size of the input */
+    int runs, passes;       /* initial runs, merge passes */
+    double formation, merge;    /* seconds */
+} external_t;
+
+typedef struct {
+    FILE *fp;
+    int *buf;
+    size_t len, pos;
+    int done;
+} run_t;
+
+/* Open an unlinked temporary file in dir */
+FILE *external_tmpfile(const char *dir)
+{
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/sortrunXXXXXX", dir);
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        perror("Unable to create run file");
+        exit(EXIT_FAILURE);
+    }
+    unlink(path);
+    FILE *fp = fdopen(fd, "w+b");
+    if (fp == NULL)
+    {
+        perror("Unable to open run file");
+        exit(EXIT_FAILURE);
+    }
+    return fp;
+}
+
+/* Write n ints, exiting on a short write (a full disk) rather than leaving a
+   truncated run or output behind */
+static void external_write(const int *buf, const size_t n, FILE *fp)
+{
+    if (n > 0 && fwrite(buf, sizeof(int), n, fp) != n)
+    {
+        perror("Error writing sorted data");
+        exit(EXIT_FAILURE);
+    }
+}
+
+/* Read up to n ints; a short read must be the end of the file, an I/O error
+   exits rather than passing a truncated file on as sorted */
+static size_t external_read(int *buf, const size_t n, FILE *fp)
+{
+    size_t m = fread(buf, sizeof(int), n, fp);
+    if (m < n && ferror(fp))
+    {
+        perror("Error reading data to sort");
+        exit(EXIT_FAILURE);
+    }
+    return m;
+}
+
+static inline void run_fill(run_t *r, const size_t capacity)
+{
+    r->len = external_read(r->buf, capacity, r->fp);
+    r->pos = 0;
+    r->done = (r->len == 0);
+}
+
+/* Leaf k is a virtual run smaller than everything, used to build the tree;
+   exhausted runs are larger than everything. */
+static inline int loser_less(const run_t run[], const int k, const int a, const int b)
+{
+    if (a == k) return 1;
+    if (b == k) return 0;
+    if (run[a].done) return 0;
+    if (run[b].done) return 1;
+    int x = run[a].buf[run[a].pos], y = run[b].buf[run[b].pos];
+    return x < y || (x == y && a < b);
+}
+
+/* Replay the matches from leaf s to the root */
+static inline void loser_adjust(int tree[], const run_t run[], const int k, int s)
+{
+    for (int t = (s + k) >> 1; t > 0; t >>= 1)
+        if (loser_less(run, k, tree[t], s))
+        {
+            int w = tree[t]; tree[t] = s; s = w;
+        }
+    tree[0] = s;
+}
+
+/* Merge the k runs (rewound) into out, with buffers of bufsize ints. */
+void external_merge(FILE *runs[], const int k, FILE *out, int *memory, const size_t bufsize)
+{
+    if (k <= 0) return;
+    run_t *run = (run_t*)malloc(k * sizeof(run_t));
+    int *tree = (int*)malloc((k + 1) * sizeof(int));
+    if (run == NULL || tree == NULL)
+    {
+        perror("Unable to allocate loser tree");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < k; i++)
+    {
+        run[i].fp = runs[i];
+        run[i].buf = memory + (size_t)i * bufsize;
+        rewind(runs[i]);
+        run_fill(&run[i], bufsize);
+    }
+    int *obuf = memory + (size_t)k * bufsize;
+    size_t olen = 0;
+
+    for (int t = 0; t <= k; t++) tree[t] = k;
+    for (int i = k - 1; i >= 0; i--) loser_adjust(tree, run, k, i);
+
+    while (1)
+    {
+        int w = tree[0];
+        if (run[w].done) break;
+        obuf[olen++] = run[w].buf[run[w].pos++];
+        if (olen == bufsize)
+        {
+            external_write(obuf, olen, out);
+            olen = 0;
+        }
+        if (run[w].pos == run[w].len) run_fill(&run[w], bufsize);
+        loser_adjust(tree, run, k, w);
+    }
+    external_write(obuf, olen, out);
+    free(run);
+    free(tree);
+}
+
+/* Sort the ints of the file in into the file out using about memory bytes.
+   sort is the in-memory method (1-indexed like the others) and scratch the
+   extra bytes per key it allocates; tmpdir holds the runs. */
+external_t externalsort(const char *in, const char *out, size_t memory,
+                        void (*sort)(const int n, int x[]), const int scratch, const char *tmpdir)
+{
+    external_t stat = {0, 0, 0, 0, 0};
+    /* A merge needs two input buffers and an output buffer */
+    if (memory < 3 * (size_t)EXTERNAL_MIN_BUFFER)
+    {
+        fprintf(stderr, "Memory budget of %zu bytes is below the minimum of %d bytes\n",
+                memory, 3 * EXTERNAL_MIN_BUFFER);
+        exit(EXIT_FAILURE);
+    }
+    FILE *fin = fopen(in, "rb");
+    if (fin == NULL)
+    {
+        perror("Unable to open input file");
+        exit(EXIT_FAILURE);
+    }
+    /* fread would drop a trailing partial int without a word */
+    struct stat st;
+    if (fstat(fileno(fin), &st) == 0 && S_ISREG(st.st_mode) && st.st_size % sizeof(int) != 0)
+    {
+        fprintf(stderr, "Input file of %lld bytes is not a whole number of %zu-byte ints\n",
+                (long long)st.st_size, sizeof(int));
+        exit(EXIT_FAILURE);
+    }
+    size_t chunk = memory / (sizeof(int) + scratch);
+    if (chunk > 2147483646) chunk = 2147483646;
+    int *buf = (int*)malloc(((chunk > memory / sizeof(int)) ? chunk : memory / sizeof(int)) * sizeof(int) + sizeof(int));
+    if (buf == NULL)
+    {
+        perror("Unable to allocate sort buffer");
+        exit(EXIT_FAILURE);
+    }
+
+    /* Run formation */
+    int capacity = 16, k = 0;
+    FILE **runs = (FILE**)malloc(capacity * sizeof(FILE*));
+    double start = bench_now();
+    size_t m;
+    while ((m = external_read(buf + 1, chunk, fin)) > 0)
+    {
+        sort((int)m, buf);
+        if (k == capacity)
+        {
+            capacity *= 2;
+            runs = (FILE**)realloc(runs, capacity * sizeof(FILE*));
+        }
+        if (runs == NULL)
+        {
+            perror("Unable to allocate run list");
+            exit(EXIT_FAILURE);
+        }
+        runs[k] = external_tmpfile(tmpdir);
+        setvbuf(runs[k], NULL, _IONBF, 0);
+        external_write(buf + 1, m, runs[k]);
+        k++;
+        stat.bytes += (double)m * sizeof(int);
+    }
+    fclose(fin);
+    stat.formation = bench_now() - start;
+    stat.runs = k;
+
+    /* Merge passes, as many runs at a time as buffers fit in memory */
+    start = bench_now();
+    int fanin = (int)(memory / EXTERNAL_MIN_BUFFER) - 1;
+    if (fanin < 2) fanin = 2;
+    FILE *fout = fopen(out, "wb");
+    if (fout == NULL)
+    {
+        perror("Unable to open output file");
+        exit(EXIT_FAILURE);
+    }
+    setvbuf(fout, NULL, _IONBF, 0);
+    while (k > fanin)
+    {
+        int merged = 0;
+        for (int i = 0; i < k; i += fanin)
+        {
+            int group = (k - i < fanin) ? k - i : fanin;
+            if (group == 1)
+            {
+                runs[merged++] = runs[i];
+                continue;
+            }
+            FILE *next = external_tmpfile(tmpdir);
+            setvbuf(next, NULL, _IONBF, 0);
+            external_merge(runs + i, group, next, buf, memory / sizeof(int) / (group + 1));
+            for (int j = i; j < i + group; j++) fclose(runs[j]);
+            runs[merged++] = next;
+        }
+        k = merged;
+        stat.passes++;
+    }
+    if (k > 0)
+    {
+        external_merge(runs, k, fout, buf, memory / sizeof(int) / (k + 1));
+        stat.passes++;
+    }
+    for (int i = 0; i < k; i++) fclose(runs[i]);
+    if (fclose(fout) != 0)
+    {
+        perror("Error writing output file");
+        exit(EXIT_FAILURE);
+    }
+    stat.merge = bench_now() - start;
+    free(runs);
+    free(buf);
+    return stat;
+}
+
+#endif
@@ -0,0 +1,219 @@
+/* The seven sorts of the assignment as type-generic code: insertion, binary
+   insertion, selection, quick, non-recursive quick, merge and heap sort.
+
+   C has no templates, so every DEFINE_ macro below stamps out a complete set
+   of functions for one element type, with the comparison given as a macro
+   LESS(a, b) that is expanded in place. The compiler therefore sees the
+   actual comparison in every inner loop, where qsort has to call through a
+   function pointer. For example
+
+       #define LESS_DOUBLE(a, b) ((a) < (b))
+       DEFINE_SORTS(_double, double, LESS_DOUBLE)
+
+   defines quicksort_double(n, x) and the others, and sort_double(n, x).
+   Like the int versions they sort x[1..n]. The quick sorts take the median
+   of 3 as pivot and push the larger side, and the merge sort is stable.
+
+   sort##suffix is the sort picked for the type at compile time. For a
+   comparison-only type it is the quicksort. DEFINE_INTEGRAL_SORTS is for
+   types ordered by an integral key KEY(x) of keybits bits; it also defines
+   radixsort##suffix, the stable LSD radix sort of radixsort.h on that key
+   (with the American flag sort as americanflagsort##suffix), and
+   sort##suffix uses it. */
+
+#ifndef __GENSORT_H__
+#define __GENSORT_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "radixsort.h"
+
+/* Ranges below this are finished by insertion sort */
+#define GENSORT_CUTOFF 16
+
+/* The seven sorts of type, ordered by LESS */
+#define DEFINE_SORT_ALGORITHMS(suffix, type, LESS)                                            \
+static inline void gen_insertion##suffix(type a[], const int l, const int r)                  \
+{                                                                                             \
+    for (int i = l + 1; i <= r; i++)                                                          \
+    {                                                                                         \
+        type y = a[i];                                                                        \
+        int j = i - 1;                                                                        \
+        while (j >= l && LESS(y, a[j])) { a[j+1] = a[j]; j--; }                               \
+        a[j+1] = y;                                                                           \
+    }                                                                                         \
+}                                                                                             \
+                                                                                              \
+void insertionsort##suffix(const int n, type x[])                                             \
+{                                                                                             \
+    gen_insertion##suffix(x, 1, n);                                                           \
+}                                                                                             \
+                                                                                              \
+void binaryinsertionsort##suffix(const int n, type x[])                                       \
+{                                                                                             \
+    for (int i = 2; i <= n; i++)                                                              \
+    {                                                                                         \
+        type y = x[i];                                                                        \
+        int l = 1, r = i - 1;                                                                 \
+        while (l <= r)                                                                        \
+        {                                                                                     \
+            int m = (l + r) >> 1;                                                             \
+            if (LESS(y, x[m])) r = m - 1; else l = m + 1;                                     \
+        }                                                                                     \
+        memmove(x + l + 1, x + l, (i - l) * sizeof(type));                                    \
+        x[l] = y;                                                                             \
+    }                                                                                         \
+}                                                                                             \
+                                                                                              \
+void selectionsort##suffix(const int n, type x[])                                             \
+{                                                                                             \
+    for (int i = 1; i < n; i++)                                                               \
+    {                                                                                         \
+        int k = i;                                                                            \
+        for (int j = i + 1; j <= n; j++) if (LESS(x[j], x[k])) k = j;                         \
+        type t = x[i]; x[i] = x[k]; x[k] = t;                                                 \
+    }                                                                                         \
+}                                                                                             \
+                                                                                              \
+/* Median of 3 to a[l], then Hoare partition; *pi, *pj as in hoarepartition */                \
+static inline void gen_partition##suffix(type a[], const int l, const int r, int *pi, int *pj)\
+{                                                                                             \
+    int m = l + (r - l) / 2, i = l, j = r;                                                    \
+    type t;                                                                                   \
+    if (LESS(a[m], a[l])) { t = a[l]; a[l] = a[m]; a[m] = t; }                                \
+    if (LESS(a[r], a[m])) { t = a[m]; a[m] = a[r]; a[r] = t; }                                \
+    if (LESS(a[m], a[l])) { t = a[l]; a[l] = a[m]; a[m] = t; }                                \
+    const type p = a[m];                                                                      \
+    while (i <= j)                                                                            \
+    {                                                                                         \
+        while (LESS(a[i], p)) i++;                                                            \
+        while (LESS(p, a[j])) j--;                                                            \
+        if (i <= j)                                                                           \
+        {                                                                                     \
+            t = a[i]; a[i] = a[j]; a[j] = t;                                                  \
+            i++; j--;                                                                         \
+        }                                                                                     \
+    }                                                                                         \
+    *pi = i; *pj = j;                                                                         \
+}                                                                                             \
+                                                                                              \
+static void gen_quicksort##suffix(type a[], int l, int r)                                     \
+{                                                                                             \
+    while (r - l >= GENSORT_CUTOFF)                                                           \
+    {                                                                                         \
+        int i, j;                                                                             \
+        gen_partition##suffix(a, l, r, &i, &j);                                               \
+        if (j - l < r - i) { gen_quicksort##suffix(a, l, j); l = i; }                         \
+        else { gen_quicksort##suffix(a, i, r); r = j; }                                       \
+    }                                                                                         \
+    gen_insertion##suffix(a, l, r);                                                           \
+}                                                                                             \
+                                                                                              \
+void quicksort##suffix(const int n, type x[])                                                 \
+{                                                                                             \
+    gen_quicksort##suffix(x, 1, n);                                                           \
+}                                                                                             \
+                                                                                              \
+void nonrecursivequicksort##suffix(const int n, type x[])                                     \
+{                                                                                             \
+    int lo[32], hi[32], s = 0, l = 1, r = n;                                                  \
+    while (1)                                                                                 \
+    {                                                                                         \
+        while (r - l >= GENSORT_CUTOFF)                                                       \
+        {                                                                                     \
+            int i, j;                                                                         \
+            gen_partition##suffix(x, l, r, &i, &j);                                           \
+            if (j - l < r - i) { lo[s] = i; hi[s] = r; r = j; }                               \
+            else { lo[s] = l; hi[s] = j; l = i; }                                             \
+            s++;                                                                              \
+        }                                                                                     \
+        gen_insertion##suffix(x, l, r);                                                       \
+        if (s == 0) break;                                                                    \
+        s--;                                                                                  \
+        l = lo[s]; r = hi[s];                                                                 \
+    }                                                                                         \
+}                                                                                             \
+                                                                                              \
+/* Sort a[l..r] through b[l..r], stable */                                                    \
+static void gen_mergesort##suffix(type a[], type b[], const int l, const int r)               \
+{                                                                                             \
+    if (r - l < GENSORT_CUTOFF)                                                               \
+    {                                                                                         \
+        gen_insertion##suffix(a, l, r);                                                       \
+        return;                                                                               \
+    }                                                                                         \
+    int m = (l + r) / 2, i = l, j = m + 1, k = l;                                             \
+    gen_mergesort##suffix(a, b, l, m);                                                        \
+    gen_mergesort##suffix(a, b, m + 1, r);                                                    \
+    if (!LESS(a[m + 1], a[m])) return;                                                        \
+    memcpy(b + l, a + l, (r - l + 1) * sizeof(type));                                         \
+    while (i <= m && j <= r)                                                                  \
+        a[k++] = LESS(b[j], b[i]) ? b[j++] : b[i++];                                          \
+    while (i <= m) a[k++] = b[i++];                                                           \
+    while (j <= r) a[k++] = b[j++];                                                           \
+}                                                                                             \
+                                                                                              \
+void mergesort##suffix(const int n, type x[])                                                 \
+{                                                                                             \
+    type *b = (type*)malloc((n + 1) * sizeof(type));                                          \
+    if (b == NULL)                                                                            \
+    {                                                                                         \
+        perror("Unable to allocate merge buffer");                                            \
+        exit(EXIT_FAILURE);                                                                   \
+    }                                                                                         \
+    gen_mergesort##suffix(x, b, 1, n);                                                        \
+    free(b);                                                                                  \
+}                                                                                             \
+                                                                                              \
+static inline void gen_sift##suffix(type a[], const int r, const int n)                       \
+{                                                                                             \
+    int i = r, j = 2 * i;                                                                     \
+    type y = a[i];                                                                            \
+    while (j <= n)                                                                            \
+    {                                                                                         \
+        if (j < n && LESS(a[j], a[j + 1])) j++;                                               \
+        if (!LESS(y, a[j])) break;                                                            \
+        a[i] = a[j]; i = j; j = 2 * i;                                                        \
+    }                                                                                         \
+    a[i] = y;                                                                                 \
+}                                                                                             \
+                                                                                              \
+void heapsort##suffix(const int n, type x[])                                                  \
+{                                                                                             \
+    for (int r = n / 2; r > 0; r--) gen_sift##suffix(x, r, n);                                \
+    for (int m = n; m > 1; m--)                                                               \
+    {                                                                                         \
+        type t = x[1]; x[1] = x[m]; x[m] = t;                                                 \
+        gen_sift##suffix(x, 1, m - 1);                                                        \
+    }                                                                                         \
+}
+
+/* Comparison sorts, sort##suffix is the quicksort */
+#define DEFINE_SORTS(suffix, type, LESS)                                                      \
+DEFINE_SORT_ALGORITHMS(suffix, type, LESS)                                                    \
+                                                                                              \
+void sort##suffix(const int n, type x[])                                                      \
+{                                                                                             \
+    quicksort##suffix(n, x);                                                                  \
+}
+
+/* Types ordered by the signed integral key KEY(x) of keybits bits, utype the
+   unsigned type of that width; sort##suffix is the radix sort */
+#define DEFINE_INTEGRAL_SORTS(suffix, type, LESS, KEY, utype, keybits)                        \
+DEFINE_SORT_ALGORITHMS(suffix, type, LESS)                                                    \
+DEFINE_RADIXSORT(suffix, type, KEY, utype, keybits)                                           \
+                                                                                              \
+void radixsort##suffix(const int n, type x[])                                                 \
+{                                                                                             \
+    lsdradixsort##suffix(n, x);                                                               \
+}                                                                                             \
+                                                                                              \
+void sort##suffix(const int n, type x[])                                                      \
+{                                                                                             \
+    radixsort##suffix(n, x);                                                                  \
+}
+
+#endif
@@ -0,0 +1,126 @@
+/* Hardware performance counters around a timed region, through Linux
+   perf_event_open: cycles, instructions, branch misses, L1 data and last
+   level cache read misses, and data TLB read misses.
+
+   Every event is opened on its own, so a PMU with fewer counters than events
+   multiplexes them and the counts are scaled by the time each one actually
+   ran. Only user space is counted. The counters are inherited by threads
+   created after perf_open, so the task pool workers of the parallel sorts
+   (started on their first run) are counted with the calling thread. Events
+   the CPU or kernel does not provide (virtual machines often have none) read
+   as NAN, and the benchmark then reports timings only. */
+
+#ifndef __PERFCOUNTER_H__
+#define __PERFCOUNTER_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+enum perfevent {PERF_CYCLES, PERF_INSTRUCTIONS, PERF_BRANCHMISSES, PERF_L1MISSES, PERF_LLCMISSES,
+                PERF_TLBMISSES, PERF_EVENTS};
+
+const char perfname[PERF_EVENTS][16] = {"cycles", "instructions", "branchmisses", "l1dmisses",
+                                        "llcmisses", "dtlbmisses"};
+
+typedef struct {
+    int fd[PERF_EVENTS];    /* -1 if the event is not available */
+    int available;          /* number of events opened */
+} perfcounter_t;
+
+#ifdef __linux__
+
+#define PERF_CACHE_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/* Open the counters, disabled. Return the number of events available. */
+int perf_open(perfcounter_t *pc)
+{
+    static const struct { uint32_t type; uint64_t config; } event[PERF_EVENTS] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_L1D)},
+        {PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_LL)},
+        {PERF_TYPE_HW_CACHE, PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB)},
+    };
+    pc->available = 0;
+    for (int e = 0; e < PERF_EVENTS; e++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event[e].type;
+        attr.config = event[e].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        pc->fd[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (pc->fd[e] >= 0) pc->available++;
+    }
+    return pc->available;
+}
+
+void perf_start(perfcounter_t *pc)
+{
+    for (int e = 0; e < PERF_EVENTS; e++)
+        if (pc->fd[e] >= 0)
+        {
+            ioctl(pc->fd[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(pc->fd[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+}
+
+/* Stop counting and store the counts since perf_start (NAN if unavailable). */
+void perf_stop(perfcounter_t *pc, double count[PERF_EVENTS])
+{
+    for (int e = 0; e < PERF_EVENTS; e++)
+        if (pc->fd[e] >= 0) ioctl(pc->fd[e], PERF_EVENT_IOC_DISABLE, 0);
+    for (int e = 0; e < PERF_EVENTS; e++)
+    {
+        uint64_t v[3];  /* value, time enabled, time running */
+        count[e] = NAN;
+        if (pc->fd[e] >= 0 && read(pc->fd[e], v, sizeof(v)) == sizeof(v) && v[2] > 0)
+            count[e] = (double)v[0] * ((double)v[1] / v[2]);
+    }
+}
+
+void perf_close(perfcounter_t *pc)
+{
+    for (int e = 0; e < PERF_EVENTS; e++)
+        if (pc->fd[e] >= 0) close(pc->fd[e]);
+    pc->available = 0;
+}
+
+#else
+
+int perf_open(perfcounter_t *pc)
+{
+    for (int e = 0; e < PERF_EVENTS; e++) pc->fd[e] = -1;
+    return pc->available = 0;
+}
+
+void perf_start(perfcounter_t *pc) { (void)pc; }
+
+void perf_stop(perfcounter_t *pc, double count[PERF_EVENTS])
+{
+    (void)pc;
+    for (int e = 0; e < PERF_EVENTS; e++) count[e] = NAN;
+}
+
+void perf_close(perfcounter_t *pc) { (void)pc; }
+
+#endif
+
+#endif
@@ -0,0 +1,163 @@
+/* Radix sorts for 32-bit and 64-bit signed integer keys.
+
+   lsdradixsort / lsdradixsort64
+   Least significant digit first, through one scratch buffer of n keys. The
+   digit width is chosen from n (8, 11 or 16 bits) so that the count tables
+   stay small next to the data, the histograms of all digits are taken in a
+   single read, and passes whose digit is the same for every key are skipped.
+   Each histogram is spread over RADIX_COUNT_TABLES tables so that runs of
+   equal digits do not wait on their own store to the same counter.
+
+   americanflagsort / americanflagsort64
+   Most significant digit first and in place (American flag sort): the keys
+   of every 8-bit bucket are permuted into place by following cycles, then
+   each bucket is sorted on the next digit. Only 2 x 256 counters per level
+   are needed, for memory-constrained runs. Small buckets are finished by
+   insertion sort.
+
+   Like the other sorts, x[1..n] is sorted. DEFINE_RADIXSORT stamps both out
+   for any element type ordered by a signed integral key KEY(x); gensort.h
+   and recordsort.h instantiate it for their types. */
+
+#ifndef __RADIXSORT_H__
+#define __RADIXSORT_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define RADIX_COUNT_TABLES 4
+#define RADIX_INSERTION 64
+
+/* Digit width for n keys */
+static inline int radixbits(const int n)
+{
+    if (n < (1 << 16)) return 8;
+    if (n < (1 << 24)) return 11;
+    return 16;
+}
+
+/* type is the element type, KEY(x) its signed key of keybits bits and utype
+   the unsigned type of that width. The sign bit is flipped so that negative
+   keys come first. */
+#define DEFINE_RADIXSORT(suffix, type, KEY, utype, keybits)                             \
+static inline utype radixkey##suffix(const type v)                                      \
+{                                                                                       \
+    return (utype)KEY(v) ^ ((utype)1 << (keybits - 1));                                 \
+}                                                                                       \
+                                                                                        \
+void lsdradixsort##suffix(const int n, type x[])                                        \
+{                                                                                       \
+    if (n < 2) return;                                                                  \
+    const int bits = radixbits(n), buckets = 1 << bits;                                 \
+    const int passes = (keybits + bits - 1) / bits;                                     \
+    const utype mask = (utype)buckets - 1;                                              \
+    size_t *count = (size_t*)calloc((size_t)RADIX_COUNT_TABLES * passes * buckets,      \
+                                    sizeof(size_t));                                    \
+    type *buf = (type*)malloc(n * sizeof(type));                                        \
+    if (count == NULL || buf == NULL)                                                   \
+    {                                                                                   \
+        perror("Unable to allocate radix sort buffers");                                \
+        exit(EXIT_FAILURE);                                                             \
+    }                                                                                   \
+    type *src = x + 1, *dst = buf;                                                      \
+                                                                                        \
+    /* All histograms in one pass, element i counted in table i % 4 */                  \
+    int i = 0;                                                                          \
+    for ( ; i + RADIX_COUNT_TABLES <= n; i += RADIX_COUNT_TABLES)                       \
+        for (int t = 0; t < RADIX_COUNT_TABLES; t++)                                    \
+        {                                                                               \
+            utype k = radixkey##suffix(src[i + t]);                                     \
+            for (int p = 0; p < passes; p++)                                            \
+                count[((size_t)t * passes + p) * buckets + ((k >> (p * bits)) & mask)]++; \
+        }                                                                               \
+    for ( ; i < n; i++)                                                                 \
+    {                                                                                   \
+        utype k = radixkey##suffix(src[i]);                                             \
+        for (int p = 0; p < passes; p++)                                                \
+            count[(size_t)p * buckets + ((k >> (p * bits)) & mask)]++;                  \
+    }                                                                                   \
+    for (int t = 1; t < RADIX_COUNT_TABLES; t++)                                        \
+        for (size_t j = 0; j < (size_t)passes * buckets; j++)                           \
+            count[j] += count[(size_t)t * passes * buckets + j];                        \
+                                                                                        \
+    for (int p = 0; p < passes; p++)                                                    \
+    {                                                                                   \
+        size_t *c = count + (size_t)p * buckets, sum = 0;                               \
+        const int shift = p * bits;                                                     \
+        if (c[(radixkey##suffix(src[0]) >> shift) & mask] == (size_t)n)                 \
+            continue;   /* every key has the same digit */                              \
+        for (int b = 0; b < buckets; b++)                                               \
+        {                                                                               \
+            size_t t = c[b];                                                            \
+            c[b] = sum;                                                                 \
+            sum += t;                                                                   \
+        }                                                                               \
+        for (int j = 0; j < n; j++)                                                     \
+            dst[c[(radixkey##suffix(src[j]) >> shift) & mask]++] = src[j];              \
+        type *t = src; src = dst; dst = t;                                              \
+    }                                                                                   \
+    if (src != x + 1) memcpy(x + 1, src, n * sizeof(type));                             \
+    free(count);                                                                        \
+    free(buf);                                                                          \
+}                                                                                       \
+                                                                                        \
+static void americanflag##suffix(type a[], const int n, const int shift)                \
+{                                                                                       \
+    if (n <= RADIX_INSERTION)                                                           \
+    {                                                                                   \
+        for (int i = 1; i < n; i++)                                                     \
+        {                                                                               \
+            type y = a[i];                                                              \
+            int j = i - 1;                                                              \
+            while (j >= 0 && radixkey##suffix(a[j]) > radixkey##suffix(y))              \
+            {                                                                           \
+                a[j+1] = a[j]; j--;                                                     \
+            }                                                                           \
+            a[j+1] = y;                                                                 \
+        }                                                                               \
+        return;                                                                         \
+    }                                                                                   \
+    int count[256] = {0}, next[256], end[256];                                          \
+    for (int i = 0; i < n; i++) count[(radixkey##suffix(a[i]) >> shift) & 0xFF]++;      \
+    for (int b = 0, sum = 0; b < 256; b++)                                              \
+    {                                                                                   \
+        next[b] = sum;                                                                  \
+        sum += count[b];                                                                \
+        end[b] = sum;                                                                   \
+    }                                                                                   \
+    /* Move every key to its bucket by following permutation cycles */                  \
+    for (int b = 0; b < 256; b++)                                                       \
+    {                                                                                   \
+        while (next[b] < end[b])                                                        \
+        {                                                                               \
+            type v = a[next[b]];                                                        \
+            int d = (radixkey##suffix(v) >> shift) & 0xFF;                              \
+            while (d != b)                                                              \
+            {                                                                           \
+                type t = a[next[d]];                                                    \
+                a[next[d]++] = v;                                                       \
+                v = t;                                                                  \
+                d = (radixkey##suffix(v) >> shift) & 0xFF;                              \
+            }                                                                           \
+            a[next[b]++] = v;                                                           \
+        }                                                                               \
+    }                                                                                   \
+    if (shift == 0) return;                                                             \
+    for (int b = 0, start = 0; b < 256; start = end[b], b++)                            \
+        if (end[b] - start > 1)                                                         \
+            americanflag##suffix(a + start, end[b] - start, shift - 8);                 \
+}                                                                                       \
+                                                                                        \
+void americanflagsort##suffix(const int n, type x[])                                    \
+{                                                                                       \
+    americanflag##suffix(x + 1, n, keybits - 8);                                        \
+}
+
+#define RADIX_VALUE(v) (v)
+
+DEFINE_RADIXSORT(, int, RADIX_VALUE, uint32_t, 32)
+DEFINE_RADIXSORT(64, long long, RADIX_VALUE, uint64_t, 64)
+
+#endif
@@ -0,0 +1,120 @@
+/* Sorting of wide records by a 4- or 8-byte signed integer key without
+   moving the records around during the sort.
+
+   recordpermutation
+   Extracts (key, index) pairs, 16 bytes each whatever the record width, and
+   sorts them with the stable LSD radix sort of radixsort.h, instantiated for
+   the pairs on their 4- or 8-byte key. The result is
+   the permutation perm with perm[i] the index of the record that belongs at
+   position i, so records can be read in order through it or gathered into
+   a new array.
+
+   applypermutation
+   Moves the records into that order in place by following the cycles of the
+   permutation, every record moved once through a single record of scratch.
+
+   recordsort
+   Both, for a stable in-place sort of the records.
+
+   Records and positions are 0-based here. */
+
+#ifndef __RECORDSORT_H__
+#define __RECORDSORT_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "radixsort.h"
+
+typedef struct {
+    int64_t key;
+    uint32_t index;
+} keyindex_t;
+
+#define KEYINDEX_KEY32(e) ((int32_t)(e).key)
+#define KEYINDEX_KEY64(e) ((e).key)
+
+DEFINE_RADIXSORT(_keyindex32, keyindex_t, KEYINDEX_KEY32, uint32_t, 32)
+DEFINE_RADIXSORT(_keyindex64, keyindex_t, KEYINDEX_KEY64, uint64_t, 64)
+
+static inline int64_t recordkey(const void *p, const int keysize)
+{
+    if (keysize == 4)
+    {
+        int32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+    int64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+/* Return the sorting permutation of the n records of width bytes at base,
+   whose keys of keysize (4 or 8) bytes are at keyoffset. The caller frees it. */
+int *recordpermutation(const void *base, const int n, const size_t width, const size_t keyoffset,
+                       const int keysize)
+{
+    keyindex_t *a = (keyindex_t*)malloc(((size_t)n + 1) * sizeof(keyindex_t));
+    int *perm = (int*)malloc(((size_t)n + 1) * sizeof(int));
+    if (a == NULL || perm == NULL)
+    {
+        perror("Unable to allocate record permutation");
+        exit(EXIT_FAILURE);
+    }
+
+    /* The only pass over the records; the sort only touches the pairs */
+    const char *rec = (const char*)base + keyoffset;
+    for (int i = 0; i < n; i++, rec += width)
+    {
+        a[i + 1].key = recordkey(rec, keysize);
+        a[i + 1].index = i;
+    }
+    if (keysize == 4)
+        lsdradixsort_keyindex32(n, a);
+    else
+        lsdradixsort_keyindex64(n, a);
+    for (int i = 0; i < n; i++) perm[i] = a[i + 1].index;
+    free(a);
+    return perm;
+}
+
+/* Put record perm[i] at position i for every i, in place. perm is used as
+   the record of finished positions and is the identity on return. */
+void applypermutation(void *base, const int n, const size_t width, int perm[])
+{
+    char *rec = (char*)base, *tmp = (char*)malloc(width);
+    if (tmp == NULL)
+    {
+        perror("Unable to allocate record buffer");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        if (perm[i] == i) continue;
+        memcpy(tmp, rec + (size_t)i * width, width);
+        int j = i;
+        while (perm[j] != i)
+        {
+            int k = perm[j];
+            memcpy(rec + (size_t)j * width, rec + (size_t)k * width, width);
+            perm[j] = j;
+            j = k;
+        }
+        memcpy(rec + (size_t)j * width, tmp, width);
+        perm[j] = j;
+    }
+    free(tmp);
+}
+
+/* Stable sort of the records by their key */
+void recordsort(void *base, const int n, const size_t width, const size_t keyoffset, const int keysize)
+{
+    int *perm = recordpermutation(base, n, width, keyoffset, keysize);
+    applypermutation(base, n, width, perm);
+    free(perm);
+}
+
+#endif
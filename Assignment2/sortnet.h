@@ -0,0 +1,221 @@
+/* Sorting networks for the small ranges at the leaves of the recursive sorts.
+
+   sortnet(a, n) sorts a[0..n-1] for n <= SORTNET_MAX. The keys are padded
+   with INT_MAX to a block of 8, 16, 32 or 64 and sorted by a bitonic network:
+   every vector register is sorted on its own by shuffle + min/max + blend
+   stages, and sorted registers are then combined by bitonic merges, two
+   registers at first and whole groups of registers later. There are no
+   data-dependent branches, so unlike insertion sort the cost does not depend
+   on the input and mispredictions do not occur.
+
+   The kernel is picked once at startup from what the CPU supports: AVX2 (8
+   ints per register), SSE4.1 (4 ints per register) or a scalar version of the
+   same network, so the same binary runs on every machine. The kernels are
+   compiled with target attributes and need no -m flags. */
+
+#ifndef __SORTNET_H__
+#define __SORTNET_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SORTNET_X86
+#endif
+
+#define SORTNET_MAX 64
+
+/* Bitonic sort of a[0..s-1], s a power of 2: the network the vector kernels
+   implement, one compare-exchange at a time. */
+static void sortnet_scalar(int a[], const int s)
+{
+    for (int k = 2; k <= s; k <<= 1)
+        for (int j = k >> 1; j > 0; j >>= 1)
+            for (int i = 0; i < s; i++)
+            {
+                int l = i ^ j;
+                if (l < i) continue;
+                int x = a[i], y = a[l], lo = (x < y) ? x : y, hi = x ^ y ^ lo;
+                if (i & k) { a[i] = hi; a[l] = lo; }
+                else { a[i] = lo; a[l] = hi; }
+            }
+}
+
+#ifdef SORTNET_X86
+
+/* One network stage: lanes whose bit is set in mask keep the larger of the
+   key and its partner p, the others the smaller. */
+#define SORTNET_COEX8(v, p, mask) \
+    _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), mask)
+#define SORTNET_COEX4(v, p, mask) \
+    _mm_castps_si128(_mm_blend_ps(_mm_castsi128_ps(_mm_min_epi32(v, p)), \
+                                  _mm_castsi128_ps(_mm_max_epi32(v, p)), mask))
+
+/* Sort a bitonic register ascending (partners at distance 4, 2, 1) */
+__attribute__((target("avx2")))
+static inline __m256i sortnet_clean8(__m256i v)
+{
+    v = SORTNET_COEX8(v, _mm256_permute2x128_si256(v, v, 1), 0xF0);
+    v = SORTNET_COEX8(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)), 0xCC);
+    v = SORTNET_COEX8(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)), 0xAA);
+    return v;
+}
+
+/* Sort 8 ints in a register: bitonic pairs, bitonic quadruples, clean */
+__attribute__((target("avx2")))
+static inline __m256i sortnet_sort8(__m256i v)
+{
+    v = SORTNET_COEX8(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)), 0x66);
+    v = SORTNET_COEX8(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)), 0x3C);
+    v = SORTNET_COEX8(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)), 0x5A);
+    return sortnet_clean8(v);
+}
+
+/* Merge the sorted registers x[0..w-1] and y[0..w-1] into x followed by y:
+   compare x with y reversed, which leaves two bitonic halves with every key
+   of x below every key of y, then clean both halves. */
+__attribute__((target("avx2")))
+static inline void sortnet_merge8(__m256i x[], __m256i y[], const int w)
+{
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    for (int i = 0; i < w; i++)
+    {
+        __m256i r = _mm256_permutevar8x32_epi32(y[w - 1 - i], reverse);
+        __m256i lo = _mm256_min_epi32(x[i], r), hi = _mm256_max_epi32(x[i], r);
+        x[i] = lo;
+        y[w - 1 - i] = _mm256_permutevar8x32_epi32(hi, reverse);
+    }
+    /* y was reversed twice; it is bitonic either way */
+    for (__m256i *z = x; z <= y; z += w)
+    {
+        for (int d = w >> 1; d > 0; d >>= 1)
+            for (int i = 0; i < w; i++)
+                if (!(i & d))
+                {
+                    __m256i lo = _mm256_min_epi32(z[i], z[i + d]);
+                    z[i + d] = _mm256_max_epi32(z[i], z[i + d]);
+                    z[i] = lo;
+                }
+        for (int i = 0; i < w; i++) z[i] = sortnet_clean8(z[i]);
+    }
+}
+
+__attribute__((target("avx2")))
+static void sortnet_avx2(int a[], const int s)
+{
+    __m256i v[SORTNET_MAX / 8];
+    const int regs = s / 8;
+    for (int i = 0; i < regs; i++)
+        v[i] = sortnet_sort8(_mm256_loadu_si256((const __m256i*)(a + 8 * i)));
+    for (int w = 1; w < regs; w <<= 1)
+        for (int g = 0; g < regs; g += 2 * w)
+            sortnet_merge8(v + g, v + g + w, w);
+    for (int i = 0; i < regs; i++)
+        _mm256_storeu_si256((__m256i*)(a + 8 * i), v[i]);
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i sortnet_clean4(__m128i v)
+{
+    v = SORTNET_COEX4(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)), 0xC);
+    v = SORTNET_COEX4(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)), 0xA);
+    return v;
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i sortnet_sort4(__m128i v)
+{
+    v = SORTNET_COEX4(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)), 0x6);
+    return sortnet_clean4(v);
+}
+
+__attribute__((target("sse4.1")))
+static inline void sortnet_merge4(__m128i x[], __m128i y[], const int w)
+{
+    for (int i = 0; i < w; i++)
+    {
+        __m128i r = _mm_shuffle_epi32(y[w - 1 - i], _MM_SHUFFLE(0, 1, 2, 3));
+        __m128i lo = _mm_min_epi32(x[i], r), hi = _mm_max_epi32(x[i], r);
+        x[i] = lo;
+        y[w - 1 - i] = _mm_shuffle_epi32(hi, _MM_SHUFFLE(0, 1, 2, 3));
+    }
+    for (__m128i *z = x; z <= y; z += w)
+    {
+        for (int d = w >> 1; d > 0; d >>= 1)
+            for (int i = 0; i < w; i++)
+                if (!(i & d))
+                {
+                    __m128i lo = _mm_min_epi32(z[i], z[i + d]);
+                    z[i + d] = _mm_max_epi32(z[i], z[i + d]);
+                    z[i] = lo;
+                }
+        for (int i = 0; i < w; i++) z[i] = sortnet_clean4(z[i]);
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void sortnet_sse(int a[], const int s)
+{
+    __m128i v[SORTNET_MAX / 4];
+    const int regs = s / 4;
+    for (int i = 0; i < regs; i++)
+        v[i] = sortnet_sort4(_mm_loadu_si128((const __m128i*)(a + 4 * i)));
+    for (int w = 1; w < regs; w <<= 1)
+        for (int g = 0; g < regs; g += 2 * w)
+            sortnet_merge4(v + g, v + g + w, w);
+    for (int i = 0; i < regs; i++)
+        _mm_storeu_si128((__m128i*)(a + 4 * i), v[i]);
+}
+
+#endif
+
+/* The kernel for this CPU, sorting a block of 8, 16, 32 or 64 ints */
+static void (*sortnet_kernel)(int a[], const int s) = sortnet_scalar;
+const char *sortnet_isa = "scalar";
+
+__attribute__((constructor))
+static void sortnet_init(void)
+{
+#ifdef SORTNET_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        sortnet_kernel = sortnet_avx2;
+        sortnet_isa = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse4.1"))
+    {
+        sortnet_kernel = sortnet_sse;
+        sortnet_isa = "sse4.1";
+    }
+#endif
+}
+
+/* Sort a[0..n-1], n <= SORTNET_MAX */
+static inline void sortnet(int a[], const int n)
+{
+#ifdef DEBUG
+    if (n > SORTNET_MAX)
+    {
+        fprintf(stderr, "sortnet: %d keys, at most %d\n", n, SORTNET_MAX);
+        exit(EXIT_FAILURE);
+    }
+#endif
+    if (n < 2) return;
+    if (n == 8 || n == 16 || n == 32 || n == 64)
+    {
+        sortnet_kernel(a, n);
+        return;
+    }
+    int buf[SORTNET_MAX], s = 8;
+    while (s < n) s <<= 1;
+    memcpy(buf, a, n * sizeof(int));
+    for (int i = n; i < s; i++) buf[i] = INT_MAX;
+    sortnet_kernel(buf, s);
+    memcpy(a, buf, n * sizeof(int));
+}
+
+#endif
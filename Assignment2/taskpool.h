@@ -0,0 +1,243 @@
+/* Small work-stealing task pool for fork-join parallelism.
+
+   Every worker owns a deque of tasks: it pushes and pops its own tasks at the
+   bottom (newest first, which keeps the working set hot), and idle workers
+   steal from the top of a random victim (oldest first, which are the largest
+   pieces of a divide-and-conquer job). A task that waits for its children
+   keeps executing other tasks instead of blocking, so recursion of any depth
+   runs on a fixed number of threads. The calling thread acts as worker 0. */
+
+#ifndef __TASKPOOL_H__
+#define __TASKPOOL_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define TASKPOOL_DEQUE 1024
+
+typedef struct task {
+    void (*fn)(void *);
+    void *arg;
+    atomic_int *pending;    /* decremented when the task is done */
+} task_t;
+
+typedef struct deque {
+    atomic_flag lock;
+    int top, bottom;        /* tasks in [top, bottom) */
+    task_t tasks[TASKPOOL_DEQUE];
+} deque_t;
+
+typedef struct taskpool {
+    int threads;
+    deque_t *deques;
+    pthread_t *tid;
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    int running;            /* a job is in progress, workers should look for tasks */
+    int shutdown;
+} taskpool_t;
+
+static _Thread_local int taskpool_self = 0;
+
+static inline void deque_lock(deque_t *d)
+{
+    while (atomic_flag_test_and_set_explicit(&d->lock, memory_order_acquire))
+        sched_yield();
+}
+
+static inline void deque_unlock(deque_t *d)
+{
+    atomic_flag_clear_explicit(&d->lock, memory_order_release);
+}
+
+/* Push at the bottom of the own deque. Return 0 when it is full. */
+static int deque_push(deque_t *d, const task_t *t)
+{
+    deque_lock(d);
+    if (d->bottom == TASKPOOL_DEQUE && d->top > 0)
+    {   /* compact */
+        for (int i = d->top; i < d->bottom; i++) d->tasks[i - d->top] = d->tasks[i];
+        d->bottom -= d->top;
+        d->top = 0;
+    }
+    int ok = d->bottom < TASKPOOL_DEQUE;
+    if (ok) d->tasks[d->bottom++] = *t;
+    deque_unlock(d);
+    return ok;
+}
+
+/* Pop the newest task of the own deque */
+static int deque_pop(deque_t *d, task_t *t)
+{
+    deque_lock(d);
+    int ok = d->bottom > d->top;
+    if (ok) *t = d->tasks[--d->bottom];
+    if (d->bottom == d->top) d->bottom = d->top = 0;
+    deque_unlock(d);
+    return ok;
+}
+
+/* Steal the oldest task of another deque */
+static int deque_steal(deque_t *d, task_t *t)
+{
+    /* Cheap peek without the lock, rechecked below */
+    if (__atomic_load_n(&d->bottom, __ATOMIC_RELAXED) <= __atomic_load_n(&d->top, __ATOMIC_RELAXED))
+        return 0;
+    deque_lock(d);
+    int ok = d->bottom > d->top;
+    if (ok) *t = d->tasks[d->top++];
+    if (d->bottom == d->top) d->bottom = d->top = 0;
+    deque_unlock(d);
+    return ok;
+}
+
+static inline void task_execute(const task_t *t)
+{
+    t->fn(t->arg);
+    atomic_fetch_sub_explicit(t->pending, 1, memory_order_release);
+}
+
+/* Find one task (own deque first, then the others) and run it. */
+static int taskpool_step(taskpool_t *pool, unsigned *seed)
+{
+    task_t t;
+    int self = taskpool_self;
+    if (deque_pop(&pool->deques[self], &t))
+    {
+        task_execute(&t);
+        return 1;
+    }
+    int start = rand_r(seed) % pool->threads;
+    for (int i = 0; i < pool->threads; i++)
+    {
+        int victim = (start + i) % pool->threads;
+        if (victim != self && deque_steal(&pool->deques[victim], &t))
+        {
+            task_execute(&t);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+typedef struct {
+    taskpool_t *pool;
+    int id;
+} taskpool_worker_t;
+
+static void *taskpool_worker(void *arg)
+{
+    taskpool_worker_t *w = (taskpool_worker_t*)arg;
+    taskpool_t *pool = w->pool;
+    unsigned seed = w->id;
+    taskpool_self = w->id;
+    free(w);
+    while (1)
+    {
+        if (!__atomic_load_n(&pool->running, __ATOMIC_ACQUIRE))
+        {   /* Sleep between jobs */
+            pthread_mutex_lock(&pool->mutex);
+            while (!pool->running && !pool->shutdown)
+                pthread_cond_wait(&pool->wake, &pool->mutex);
+            int shutdown = pool->shutdown;
+            pthread_mutex_unlock(&pool->mutex);
+            if (shutdown) break;
+        }
+        if (!taskpool_step(pool, &seed))
+            sched_yield();
+    }
+    return NULL;
+}
+
+/* Create a pool of the given number of threads, the caller included, or of
+   fewer if not all of them can be started. */
+taskpool_t *taskpool_create(int threads)
+{
+    if (threads < 1) threads = 1;
+    taskpool_t *pool = (taskpool_t*)calloc(1, sizeof(taskpool_t));
+    if (pool == NULL || (pool->deques = (deque_t*)calloc(threads, sizeof(deque_t))) == NULL
+        || (pool->tid = (pthread_t*)calloc(threads, sizeof(pthread_t))) == NULL)
+    {
+        perror("Unable to allocate task pool");
+        exit(EXIT_FAILURE);
+    }
+    pool->threads = threads;
+    for (int i = 0; i < threads; i++) atomic_flag_clear(&pool->deques[i].lock);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    for (int i = 1; i < threads; i++)
+    {
+        taskpool_worker_t *w = (taskpool_worker_t*)malloc(sizeof(taskpool_worker_t));
+        if (w == NULL)
+        {
+            perror("Unable to allocate task pool");
+            exit(EXIT_FAILURE);
+        }
+        w->pool = pool;
+        w->id = i;
+        if (pthread_create(&pool->tid[i], NULL, taskpool_worker, w) != 0)
+        {
+            /* Go on with the workers started so far. They only look at
+               pool->threads once a job runs, after this returns. */
+            free(w);
+            pool->threads = i;
+            break;
+        }
+    }
+    return pool;
+}
+
+void taskpool_destroy(taskpool_t *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+    for (int i = 1; i < pool->threads; i++) pthread_join(pool->tid[i], NULL);
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->wake);
+    free(pool->deques);
+    free(pool->tid);
+    free(pool);
+}
+
+/* Make fn(arg) available to the other workers; *pending is incremented now
+   and decremented once it has run. Runs it at once if the deque is full. */
+void taskpool_spawn(taskpool_t *pool, void (*fn)(void *), void *arg, atomic_int *pending)
+{
+    task_t t = {fn, arg, pending};
+    atomic_fetch_add_explicit(pending, 1, memory_order_relaxed);
+    if (!deque_push(&pool->deques[taskpool_self], &t))
+        task_execute(&t);
+}
+
+/* Run other tasks until *pending drops to zero. */
+void taskpool_wait(taskpool_t *pool, atomic_int *pending)
+{
+    unsigned seed = taskpool_self + 1;
+    while (atomic_load_explicit(pending, memory_order_acquire) > 0)
+        if (!taskpool_step(pool, &seed))
+            sched_yield();
+}
+
+/* Run fn(arg) on the calling thread with the pool's workers helping, and
+   return when it and everything it spawned is done. */
+void taskpool_run(taskpool_t *pool, void (*fn)(void *), void *arg)
+{
+    pthread_mutex_lock(&pool->mutex);
+    __atomic_store_n(&pool->running, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->mutex);
+
+    taskpool_self = 0;
+    fn(arg);
+
+    pthread_mutex_lock(&pool->mutex);
+    __atomic_store_n(&pool->running, 0, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+#endif
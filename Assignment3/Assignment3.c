@@ -6,6 +6,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <assert.h>
 #include <time.h>
 
@@ -17,6 +19,11 @@
 #include "position.h"
 #include "path.h"
 #include "queue.h"
+#include "bucketqueue.h"
+#include "parallelbfs.h"
+#include "bitboard.h"
+#include "mazegen.h"
+#include "mazeload.h"
 
 
 #define INFTY 2147483647
@@ -28,65 +35,512 @@ typedef struct {
 
 direction move[dir] = {{1,0},{-1,0},{0,1},{0,-1}};
 
+// Threads of the parallel search, 0 for one per processor.
+int bfs_threads = 0;
+
+// Bitset with one bit per cell, for the visited map of the search.
+static inline int bit_test(const uint64_t *bits, const uint32_t i){
+    return (bits[i >> 6] >> (i & 63)) & 1;
+}
+
+static inline void bit_set(uint64_t *bits, const uint32_t i){
+    bits[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+// Expand one level of the frontier of one side of the bidirectional search:
+// the cells dequeued are those of the current level, the cells enqueued the
+// next. A neighbor already reached by the other side joins the two halves;
+// the shortest such join of the level is kept in best, with *s_meet and
+// *t_meet its start-side and end-side cells. Return the cells expanded.
+static long long expand_level(const maze_t* maze, int *distance, queue_t *q, uint64_t *visited,
+                              const uint64_t *other, const int side, long long *best,
+                              uint32_t *s_meet, uint32_t *t_meet)
+{
+    const int height = maze->height, width = maze->width;
+    long long expanded = 0;
+    for (size_t level = q->size; level > 0; level--)
+    {
+        uint32_t point = dequeue(q);
+        int row = point / width, col = point - row * width;
+        expanded++;
+        for (int i = 0; i < dir; i++)
+        {
+            int adjacent_row = row + move[i].v, adjacent_col = col + move[i].h;
+            if (adjacent_col < 0 || adjacent_row < 0 || adjacent_col >= width || adjacent_row >= height){
+                continue;
+            }
+            uint32_t adjacent = (uint32_t)adjacent_row * width + adjacent_col;
+            if (maze->cells[adjacent] == BLOCKED || bit_test(visited, adjacent))
+            {
+                continue;
+            }
+            if (bit_test(other, adjacent))
+            {
+                long long length = (long long)distance[point] + 1 + distance[adjacent];
+                if (length < *best)
+                {
+                    *best = length;
+                    *s_meet = side ? adjacent : point;
+                    *t_meet = side ? point : adjacent;
+                }
+                continue;
+            }
+            bit_set(visited, adjacent);
+            distance[adjacent] = distance[point] + 1;
+            enqueue(q, adjacent);
+        }
+    }
+    return expanded;
+}
+
+// Bidirectional BFS for opt = 2. Both S and T grow a frontier, one level at
+// a time and always the smaller frontier, until a level joins them. Until
+// then every reached cell belongs to one side and distance holds its distance
+// from that side. Afterwards the start half of the path is traced back from
+// the join and given its distance to T, and the other start-side cells are
+// reset to INFTY, so that distance reads as in mazeBFS for shortest_path.
+long long bidirectionalBFS( const maze_t* maze, int *distance)
+{
+    const int height = maze->height, width = maze->width;
+    const size_t cells = (size_t)height * width, words = (cells + 63) / 64;
+    uint64_t *visited[2] = {(uint64_t*)calloc(words, sizeof(uint64_t)),
+                            (uint64_t*)calloc(words, sizeof(uint64_t))};
+    queue_t q[2];
+    if (visited[0] == NULL || visited[1] == NULL || !queue_create(&q[0], cells) || !queue_create(&q[1], cells))
+    {
+        perror("Unable to allocate search state");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < cells; i++)
+    {
+        distance[i] = INFTY;
+    }
+
+    // Side 0 grows from S, side 1 from T.
+    uint32_t source[2] = {offset(maze, maze->start), offset(maze, maze->end)};
+    for (int side = 0; side < 2; side++)
+    {
+        distance[source[side]] = 0;
+        bit_set(visited[side], source[side]);
+        enqueue(&q[side], source[side]);
+    }
+    long long best = INFTY, expanded = 0;
+    uint32_t s_meet = 0, t_meet = 0;
+    while (best == INFTY && !queue_empty(&q[0]) && !queue_empty(&q[1]))
+    {
+        int side = q[1].size < q[0].size;
+        expanded += expand_level(maze, distance, &q[side], visited[side], visited[!side], side,
+                                 &best, &s_meet, &t_meet);
+    }
+
+    if (best != INFTY)
+    {
+        // Collect the start half, from the join back to S.
+        int s_length = distance[s_meet];
+        uint32_t *half = (uint32_t*)malloc((s_length + 1) * sizeof(uint32_t));
+        if (half == NULL)
+        {
+            perror("Unable to allocate path");
+            exit(EXIT_FAILURE);
+        }
+        half[s_length] = s_meet;
+        for (int d = s_length; d > 0; d--)
+        {
+            int row = half[d] / width, col = half[d] - row * width;
+            for (int i = 0; i < dir; i++)
+            {
+                int adjacent_row = row + move[i].v, adjacent_col = col + move[i].h;
+                if (adjacent_col < 0 || adjacent_row < 0 || adjacent_col >= width || adjacent_row >= height){
+                    continue;
+                }
+                uint32_t adjacent = (uint32_t)adjacent_row * width + adjacent_col;
+                if (bit_test(visited[0], adjacent) && distance[adjacent] == d - 1)
+                {
+                    half[d - 1] = adjacent;
+                    break;
+                }
+            }
+        }
+        for (size_t w = 0; w < words; w++)
+        {
+            for (uint64_t bits = visited[0][w]; bits; bits &= bits - 1)
+            {
+                distance[w * 64 + __builtin_ctzll(bits)] = INFTY;
+            }
+        }
+        for (int d = 0; d <= s_length; d++)
+        {
+            distance[half[d]] = (int)best - d;
+        }
+        free(half);
+    }
+    else
+    {
+        distance[source[0]] = INFTY;
+    }
+    for (int side = 0; side < 2; side++)
+    {
+        queue_free(&q[side]);
+        free(visited[side]);
+    }
+    return expanded;
+}
+
+// Whether a cell is inside the maze and not a wall.
+static inline int passable(const maze_t* maze, const int row, const int col){
+    return row >= 0 && col >= 0 && row < maze->height && col < maze->width
+        && maze->cells[(size_t)row * maze->width + col] != BLOCKED;
+}
+
+// Manhattan distance from a cell to S, the heuristic of the A* searches.
+static inline int manhattan(const maze_t* maze, const uint32_t cell){
+    int row = cell / maze->width, col = cell - row * maze->width;
+    return abs(row - maze->start.row) + abs(col - maze->start.col);
+}
+
+// Allocate the closed set and open list of an A* search and reset distance.
+static void astar_initialize(const maze_t* maze, int *distance, uint64_t **closed, bucketqueue_t *open)
+{
+    const size_t cells = (size_t)maze->height * maze->width;
+    *closed = (uint64_t*)calloc((cells + 63) / 64, sizeof(uint64_t));
+    if (*closed == NULL || !bucketqueue_create(open, 1024, (maze->height + maze->width) / 2 + 1))
+    {
+        perror("Unable to allocate search state");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < cells; i++)
+    {
+        distance[i] = INFTY;
+    }
+}
+
+// A* for opt = 3, from T towards S with the Manhattan distance to S as the
+// heuristic. The heuristic is consistent and every step costs 1, so f = g + h
+// never decreases along the search and keeps its parity: the open list is a
+// bucket queue on f / 2, and within a bucket the cell pushed last (the
+// deepest) is expanded first. A cell improved while open is pushed again and
+// the stale entry skipped when popped. Distances are exact for the closed
+// cells and upper bounds for the open ones, which is all shortest_path needs.
+long long mazeAstar( const maze_t* maze, int *distance)
+{
+    const int height = maze->height, width = maze->width;
+    uint64_t *closed;
+    bucketqueue_t open;
+    astar_initialize(maze, distance, &closed, &open);
+
+    uint32_t source = offset(maze, maze->end), goal = offset(maze, maze->start);
+    distance[source] = 0;
+    bucketqueue_push(&open, manhattan(maze, source) / 2, source);
+    long long expanded = 0;
+    while (!bucketqueue_empty(&open))
+    {
+        size_t key;
+        uint32_t point = bucketqueue_pop(&open, &key);
+        if (bit_test(closed, point))
+        {
+            continue;
+        }
+        bit_set(closed, point);
+        expanded++;
+        if (point == goal)
+        {
+            break;
+        }
+        int row = point / width, col = point - row * width;
+        for (int i = 0; i < dir; i++)
+        {
+            int adjacent_row = row + move[i].v, adjacent_col = col + move[i].h;
+            if (adjacent_col < 0 || adjacent_row < 0 || adjacent_col >= width || adjacent_row >= height){
+                continue;
+            }
+            uint32_t adjacent = (uint32_t)adjacent_row * width + adjacent_col;
+            if (maze->cells[adjacent] == BLOCKED || bit_test(closed, adjacent)
+                || distance[point] + 1 >= distance[adjacent])
+            {
+                continue;
+            }
+            distance[adjacent] = distance[point] + 1;
+            if (!bucketqueue_push(&open, (distance[adjacent] + manhattan(maze, adjacent)) / 2, adjacent))
+            {
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    bucketqueue_free(&open);
+    free(closed);
+    return expanded;
+}// mazeAstar
+
+// Jump from (row, col) along direction i of move until a jump point: the goal,
+// or for a horizontal move a cell whose vertical neighbor is open while the
+// one behind it is a wall (a forced neighbor), or for a vertical move a cell
+// from which a horizontal jump succeeds. Paths are taken as vertical steps
+// first, so only these cells are places where a shortest path must turn.
+// Return the jump point, or -1 if the jump runs into a wall.
+static long long jump(const maze_t* maze, int row, int col, const int i, const uint32_t goal)
+{
+    const int v = move[i].v, h = move[i].h;
+    while (1)
+    {
+        row += v;
+        col += h;
+        if (!passable(maze, row, col))
+        {
+            return -1;
+        }
+        uint32_t cell = (uint32_t)row * maze->width + col;
+        if (cell == goal)
+        {
+            return cell;
+        }
+        if (v == 0)
+        {
+            if ((passable(maze, row - 1, col) && !passable(maze, row - 1, col - h))
+                || (passable(maze, row + 1, col) && !passable(maze, row + 1, col - h)))
+            {
+                return cell;
+            }
+        }
+        else if (jump(maze, row, col, 2, goal) >= 0 || jump(maze, row, col, 3, goal) >= 0)
+        {
+            return cell;
+        }
+    }
+}
+
+// Jump Point Search for opt = 4: A* as in mazeAstar over the jump points only,
+// with the direction each one was reached from kept in from. A point reached
+// vertically (or the source) continues in every direction but back, one
+// reached horizontally continues straight and turns only towards forced
+// neighbors. On success the path is walked back through the jump points, all
+// distances are reset, and the cells of the path alone get their distance to
+// T, so that shortest_path follows it.
+long long mazeJPS( const maze_t* maze, int *distance)
+{
+    const int width = maze->width;
+    const size_t cells = (size_t)maze->height * width;
+    uint64_t *closed, *touched = (uint64_t*)calloc((cells + 63) / 64, sizeof(uint64_t));
+    unsigned char *from = (unsigned char*)malloc(cells);
+    bucketqueue_t open;
+    if (touched == NULL || from == NULL)
+    {
+        perror("Unable to allocate search state");
+        exit(EXIT_FAILURE);
+    }
+    astar_initialize(maze, distance, &closed, &open);
+
+    uint32_t source = offset(maze, maze->end), goal = offset(maze, maze->start);
+    distance[source] = 0;
+    from[source] = dir;
+    bit_set(touched, source);
+    bucketqueue_push(&open, manhattan(maze, source) / 2, source);
+    long long expanded = 0;
+    while (!bucketqueue_empty(&open))
+    {
+        size_t key;
+        uint32_t point = bucketqueue_pop(&open, &key);
+        if (bit_test(closed, point))
+        {
+            continue;
+        }
+        bit_set(closed, point);
+        expanded++;
+        if (point == goal)
+        {
+            break;
+        }
+        int row = point / width, col = point - row * width, arrival = from[point];
+        for (int i = 0; i < dir; i++)
+        {
+            if (arrival < dir && (i ^ 1) == arrival)
+            {
+                continue;   // back where it came from
+            }
+            if (arrival >= 2 && arrival < dir && i != arrival)
+            {
+                // Horizontal arrival: turn only towards a forced neighbor
+                if (!passable(maze, row + move[i].v, col)
+                    || passable(maze, row + move[i].v, col - move[arrival].h))
+                {
+                    continue;
+                }
+            }
+            long long jumped = jump(maze, row, col, i, goal);
+            if (jumped < 0 || bit_test(closed, (uint32_t)jumped))
+            {
+                continue;
+            }
+            uint32_t next = (uint32_t)jumped;
+            int steps = abs((int)(next / width) - row) + abs((int)(next % width) - col);
+            if (distance[point] + steps >= distance[next])
+            {
+                continue;
+            }
+            distance[next] = distance[point] + steps;
+            from[next] = i;
+            bit_set(touched, next);
+            if (!bucketqueue_push(&open, (distance[next] + manhattan(maze, next)) / 2, next))
+            {
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    if (bit_test(closed, goal))
+    {
+        // Collect the jump points of the path, from S back to T.
+        size_t count = 0, capacity = 64;
+        uint32_t *points = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+        for (uint32_t point = goal; ; )
+        {
+            if (count == capacity)
+            {
+                capacity *= 2;
+                points = (uint32_t*)realloc(points, capacity * sizeof(uint32_t));
+            }
+            if (points == NULL)
+            {
+                perror("Unable to allocate path");
+                exit(EXIT_FAILURE);
+            }
+            points[count++] = point;
+            if (point == source)
+            {
+                break;
+            }
+            // The parent lies straight back along the arrival direction.
+            int i = from[point], d = distance[point];
+            do
+            {
+                point -= move[i].v * width + move[i].h;
+                d--;
+            } while (!bit_test(closed, point) || distance[point] != d);
+        }
+        for (size_t w = 0; w < (cells + 63) / 64; w++)
+        {
+            for (uint64_t bits = touched[w]; bits; bits &= bits - 1)
+            {
+                distance[w * 64 + __builtin_ctzll(bits)] = INFTY;
+            }
+        }
+        // Give every cell between consecutive jump points its distance.
+        for (size_t k = count - 1; k > 0; k--)
+        {
+            uint32_t point = points[k];
+            int i = from[points[k - 1]], d = (k == count - 1) ? 0 : distance[point];
+            distance[point] = d;
+            while (point != points[k - 1])
+            {
+                point += move[i].v * width + move[i].h;
+                distance[point] = ++d;
+            }
+        }
+        free(points);
+    }
+    bucketqueue_free(&open);
+    free(closed);
+    free(touched);
+    free(from);
+    return expanded;
+}// mazeJPS
+
 /*  opt = 0 => end when reach terminal. 
-*   opt = 1 => search whole maze. */
-void mazeBFS( const maze_t* maze, int *distance, const int opt)
+*   opt = 1 => search whole maze.
+*   opt = 2 => bidirectional search from both ends (see bidirectionalBFS).
+*   opt = 3 => A* search (see mazeAstar).
+*   opt = 4 => Jump Point Search (see mazeJPS).
+*   opt = 5 => parallel BFS on bfs_threads threads (see parallelbfs.h).
+*   Any other opt searches the whole maze like 1. That includes 6, the
+*   bitboard search, which works on a bitboard_t and is run by main through
+*   bitboardBFS (see bitboard.h).
+*   Cells are handled as packed offsets (width*row + col) in a preallocated
+*   ring buffer, and the visited cells are kept in a bitset, so the search
+*   allocates three blocks whatever the maze size and leaves the maze intact.
+*   Return the number of cells expanded. */
+long long mazeBFS( const maze_t* maze, int *distance, const int opt)
 {
     assert(maze != NULL);
-    cell_t maze_cells[maze->height*maze->width];
-
-    for (int i = 0; i < maze->height*maze->width; i++)
+    const int height = maze->height, width = maze->width;
+    const size_t cells = (size_t)height * width;
+    if (cells > UINT32_MAX)
+    {
+        fprintf(stderr, "Maze of %zu cells is too large, at most %u\n", cells, UINT32_MAX);
+        exit(EXIT_FAILURE);
+    }
+    switch (opt)
+    {
+    case 2:
+        return bidirectionalBFS(maze, distance);
+    case 3:
+        return mazeAstar(maze, distance);
+    case 4:
+        return mazeJPS(maze, distance);
+    case 5:
+        return parallelBFS(maze, distance, bfs_threads);
+    default:
+        break;
+    }
+    uint64_t *visited = (uint64_t*)calloc((cells + 63) / 64, sizeof(uint64_t));
+    queue_t q;
+    if (visited == NULL || !queue_create(&q, cells))
+    {
+        perror("Unable to allocate search state");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < cells; i++)
     {
         distance[i] = INFTY;
-        maze_cells[i] = maze->cells[i];
     }
 
-    distance[offset(maze, maze->end)] = 0;
-    list_t adjacent_point;
-    position_t adjacent;
-    adjacent_point.position = maze->end;
-    adjacent_point.next = NULL;
-    queue_t q = {NULL, NULL};
-    enqueue(&q, &adjacent_point);
-    int flag = 0;
+    uint32_t end = offset(maze, maze->end);
+    distance[end] = 0;
+    bit_set(visited, end);
+    enqueue(&q, end);
+    long long expanded = 0;
     while (!queue_empty(&q))
     {
-        list_t * point = dequeue(&q);
+        uint32_t point = dequeue(&q);
+        int row = point / width, col = point - row * width;
+        expanded++;
         for (int i = 0; i < dir; i++)
         {
-            adjacent.col = point->position.col + move[i].h;
-            adjacent.row = point->position.row + move[i].v;
-            if (adjacent.col < 0 || adjacent.row < 0 || adjacent.col > maze->width || adjacent.row > maze->height){
+            int adjacent_row = row + move[i].v, adjacent_col = col + move[i].h;
+            if (adjacent_col < 0 || adjacent_row < 0 || adjacent_col >= width || adjacent_row >= height){
                 continue;
             }
-            adjacent_point.position = adjacent;
-            switch (maze_cells[offset(maze, adjacent)])
+            uint32_t adjacent = (uint32_t)adjacent_row * width + adjacent_col;
+            if (bit_test(visited, adjacent))
+            {
+                continue;
+            }
+            switch (maze->cells[adjacent])
             {
             case OPEN:
-                enqueue(&q, &adjacent_point);
-                maze_cells[offset(maze, adjacent)] = VISITED;
-                distance[offset(maze, adjacent)] = distance[offset(maze, point->position)] + 1;
+                bit_set(visited, adjacent);
+                distance[adjacent] = distance[point] + 1;
+                enqueue(&q, adjacent);
                 break; 
             case START:
-                if (!opt && !flag)
+                bit_set(visited, adjacent);
+                distance[adjacent] = distance[point] + 1;
+                if (!opt)
                 {
-                    flag = 1;
-                    distance[offset(maze, adjacent)] = distance[offset(maze, point->position)] + 1;
                     queue_initialize(&q);
+                    i = dir;
                 }
-                else if (!flag)
+                else
                 {
-                    flag = 1;
-                    enqueue(&q, &adjacent_point);
-                    distance[offset(maze, adjacent)] = distance[offset(maze, point->position)] + 1;
+                    enqueue(&q, adjacent);
                 }
                 break;
             default:
                 break;
             }
         }
-        free(point);
     }
+    queue_free(&q);
+    free(visited);
+    return expanded;
 }// mazeBFS
 
 // Return the path lists containing the shortest path from end position to start position.
@@ -95,7 +549,7 @@ list_t * shortest_path( const maze_t* maze, const int *distance, cell_t *path_ce
     position_t adjacent;
     path->next = NULL;
     path->position = maze->start;
-    for (int i = 0; i < maze->height * maze->width; i++)
+    for (size_t i = 0; i < (size_t)maze->height * maze->width; i++)
     {
         path_cells[i] = OPEN;
     }
@@ -109,8 +563,11 @@ list_t * shortest_path( const maze_t* maze, const int *distance, cell_t *path_ce
     {
         for (int i = 0; i < dir; i++)
         {
-            adjacent.col = path->position.col + move[i].v;
-            adjacent.row = path->position.row + move[i].h;
+            adjacent.col = path->position.col + move[i].h;
+            adjacent.row = path->position.row + move[i].v;
+            if (adjacent.col < 0 || adjacent.row < 0 || adjacent.col >= maze->width || adjacent.row >= maze->height){
+                continue;
+            }
             if(distance[offset(maze, adjacent)] == d - 1){
                 d--;
                 if(d!=0) path_cells[offset(maze, adjacent)] = PATH;
@@ -122,40 +579,159 @@ list_t * shortest_path( const maze_t* maze, const int *distance, cell_t *path_ce
     return path;
 }
 
-int main(void){
+void usage(const char *program){
+    fprintf(stderr, "Usage: %s [mazefile [opt]]\n"
+                    "       %s bench mazefile [opt [threads]]\n"
+                    "       %s generate height width mazefile [seed [open]]\n"
+                    "       %s convert mazefile binaryfile\n"
+                    "The default maze file is maze79.txt and opt selects the search: 0\n"
+                    "(BFS from T to S, default), 1 (BFS of the whole maze), 2 (bidirectional BFS),\n"
+                    "3 (A*), 4 (Jump Point Search), 5 (parallel BFS, on all processors unless\n"
+                    "threads is given) or 6 (word-parallel BFS on a bitboard).\n"
+                    "bench times the search without printing the maze; generate writes a random\n"
+                    "maze, with a fraction open of its inner walls removed; convert writes a maze\n"
+                    "in the binary format, which is read like a text maze file.\n", program, program, program, program);
+}
+
+int main(int argc, char *argv[]){
     clock_t start, end;
-    double cpu_time_used = 0;
+    struct timespec wall_start, wall_end;
+    double cpu_time_used = 0, wall_time_used = 0;
 
-    // Read maze file
-    FILE * fp;
-    fp = fopen ("maze79.txt", "r");
-    maze_t *maze = readMaze(fp);
-    fclose(fp);
+    if (argc > 4 && strcmp(argv[1], "generate") == 0){
+        maze_t *maze = generateMaze(atoi(argv[2]), atoi(argv[3]), (argc > 5) ? strtoull(argv[5], NULL, 10) : 1,
+                                     (argc > 6) ? atof(argv[6]) : 0);
+        if (maze == NULL) return EXIT_FAILURE;
+        FILE *fp = fopen(argv[4], "w");
+        if (fp == NULL){
+            perror("Unable to open maze file");
+            return EXIT_FAILURE;
+        }
+        writeMaze(fp, maze);
+        freeMaze(maze);
+        if (fclose(fp) != 0){
+            perror("Error writing maze");
+            return EXIT_FAILURE;
+        }
+        return 0;
+    }
+    if (argc == 4 && strcmp(argv[1], "convert") == 0){
+        maze_t *maze = loadMaze(argv[2]);
+        if (maze == NULL) return EXIT_FAILURE;
+        FILE *fp = fopen(argv[3], "wb");
+        if (fp == NULL){
+            perror("Unable to open maze file");
+            return EXIT_FAILURE;
+        }
+        writeMazeBinary(fp, maze);
+        freeMaze(maze);
+        if (fclose(fp) != 0){
+            perror("Error writing maze");
+            return EXIT_FAILURE;
+        }
+        return 0;
+    }
+    int bench = (argc > 2 && strcmp(argv[1], "bench") == 0);
+    if (argc > 3 + 2 * bench || (argc == 2 && strcmp(argv[1], "bench") == 0)){
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const char *file = (argc > 1 + bench) ? argv[1 + bench] : "maze79.txt";
+    int opt = (argc > 2 + bench) ? atoi(argv[2 + bench]) : 0;
+    if (bench && argc > 4){
+        bfs_threads = atoi(argv[4]);
+    }
 
-    // Declare distance array and path cell array.
-    int maze_size = maze->height * maze->width;
-    int distance[maze_size];
-    cell_t path_cells[maze_size];
+    // Read maze file
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+    maze_t *maze = loadMaze(file);
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    if (maze == NULL){
+        return EXIT_FAILURE;
+    }
+    if (bench){
+        printf("Maze loaded in : %.16f\n",
+               (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9);
+    }
 
     // Search the maze and find the shortest path.
-    start = clock();
-    mazeBFS(maze, distance, 0);
-    list_t *path = shortest_path(maze, distance, path_cells);
-    end = clock();
+    long long expanded;
+    int length;
+    list_t *path;
+    double build_time = -1;
+    if (opt == 6){
+        // Bitboard search, on a board built beforehand (and timed apart),
+        // or mapped from a binary maze file.
+        clock_gettime(CLOCK_MONOTONIC, &wall_start);
+        bitboard_t *board = mapBitboard(file);
+        if (board == NULL){
+            board = bitboard_create(maze);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &wall_end);
+        if (board == NULL){
+            return EXIT_FAILURE;
+        }
+        build_time = (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+        start = clock();
+        clock_gettime(CLOCK_MONOTONIC, &wall_start);
+        length = bitboardBFS(board, maze->end, maze->start, &path, &expanded);
+        end = clock();
+        clock_gettime(CLOCK_MONOTONIC, &wall_end);
+        bitboard_free(board);
+        if (path == NULL){
+            printf("No path from start to end.\n");
+        }
+        for (list_t *p = path; p != NULL; p = p->next)
+        {
+            cell_t *cell = &maze->cells[offset(maze, p->position)];
+            if (*cell == OPEN)
+            {
+                *cell = PATH;
+            }
+        }
+    }else{
+        // Allocate distance array and path cell array.
+        size_t maze_size = (size_t)maze->height * maze->width;
+        int *distance = (int*)malloc(maze_size * sizeof(int));
+        cell_t *path_cells = (cell_t*)malloc(maze_size * sizeof(cell_t));
+        if (distance == NULL || path_cells == NULL){
+            perror("Unable to allocate distance array");
+            return EXIT_FAILURE;
+        }
 
-    // Output section.
-    for (int i = 0; i < maze_size; i++)
-    {
-        if (path_cells[i] == PATH)
+        start = clock();
+        clock_gettime(CLOCK_MONOTONIC, &wall_start);
+        expanded = mazeBFS(maze, distance, opt);
+        path = shortest_path(maze, distance, path_cells);
+        end = clock();
+        clock_gettime(CLOCK_MONOTONIC, &wall_end);
+
+        for (size_t i = 0; i < maze_size; i++)
         {
-            maze->cells[i] = PATH;
+            if (path_cells[i] == PATH)
+            {
+                maze->cells[i] = PATH;
+            }
         }
+        length = distance[offset(maze, maze->start)];
+        free(distance);
+        free(path_cells);
     }
+
+    // Output section.
     cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
-    printMaze(maze);
-    list_print_reverse(path);
-    printf("\n\nShortest path length : %d\n",offset(maze, maze->start));
+    wall_time_used = (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+    if (!bench){
+        printMaze(maze);
+        list_print_reverse(path);
+    }
+    printf("\n\nShortest path length : %d\n", length);
     printf("Cpu time used : %.16f\n", cpu_time_used);
+    printf("Wall time used : %.16f\n", wall_time_used);
+    printf("Cells expanded : %lld (%.0f cells/s)\n", expanded, expanded / wall_time_used);
+    if (build_time >= 0){
+        printf("Bitboard built in : %.16f\n", build_time);
+    }
 
     // Free all the dynamic allocated memories.
     list_free(path);
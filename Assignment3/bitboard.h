@@ -0,0 +1,388 @@
+/* Bitboard representation of the maze and a word-parallel BFS on it.
+
+   Every row is a run of uint64 words, bit b of word w standing for column
+   64 w + b. The board is padded by one zero word on either side of each row
+   and one zero row above and below, so neighbors never need bounds checks.
+
+   bitboardBFS advances the whole frontier one level per step, 64 cells per
+   operation:
+
+       next = (F << 1 | F >> 1 | F of the row above | F of the row below
+               | carries from the neighboring words) & ~visited
+
+   with the walls (and the bits past the last column) set in visited from
+   the start. Only the words next to a nonzero frontier word can change, so
+   every step lists the nonzero words of the frontier by row, merges those
+   of the rows above, at and below each row into runs of words, and
+   evaluates just the runs; runs of 8 words or more go through AVX2, 4 words
+   at a time, when the CPU has it. The search keeps no distances: the list
+   of the nonzero frontier words of every level is its snapshot, and the
+   path is found by walking back from the target through the snapshots. */
+
+#ifndef __BITBOARD_H__
+#define __BITBOARD_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/mman.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITBOARD_X86
+#endif
+
+#include "maze.h"
+#include "path.h"
+
+/* Runs of at least this many words use AVX2 */
+#define BITBOARD_WIDE 8
+
+typedef struct bitboard {
+    int height, width;
+    int words;          /* words per row, without padding */
+    int stride;         /* words per row, with padding */
+    uint64_t *walls;    /* (height + 2) * stride words */
+    void *map;          /* mapping walls points into, or NULL if allocated */
+    size_t map_size;
+} bitboard_t;
+
+/* Levels of the search: the nonzero words (index and bits) of each frontier */
+typedef struct {
+    uint32_t *index;
+    uint64_t *bits;
+    size_t size, capacity;
+    size_t *level;      /* level l is [level[l], level[l + 1]) */
+    size_t levels, level_capacity;
+} bitboard_snapshots_t;
+
+static int bitboard_avx2 = 0;
+
+__attribute__((constructor))
+static void bitboard_init(void)
+{
+#ifdef BITBOARD_X86
+    __builtin_cpu_init();
+    bitboard_avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+/* Build the bitboard of a maze read by readMaze. Return NULL if out of memory. */
+bitboard_t *bitboard_create(const maze_t *maze)
+{
+    assert(maze != NULL);
+    bitboard_t *board = (bitboard_t*)malloc(sizeof(bitboard_t));
+    if (board == NULL)
+    {
+        perror("Unable to allocate bitboard");
+        return NULL;
+    }
+    board->height = maze->height;
+    board->width = maze->width;
+    board->words = (maze->width + 63) / 64;
+    board->stride = board->words + 2;
+    board->map = NULL;
+    board->map_size = 0;
+    board->walls = (uint64_t*)calloc((size_t)(board->height + 2) * board->stride, sizeof(uint64_t));
+    if (board->walls == NULL)
+    {
+        perror("Unable to allocate bitboard");
+        free(board);
+        return NULL;
+    }
+    const cell_t *p_cell = maze->cells;
+    for (int row = 0; row < maze->height; row++)
+    {
+        uint64_t *w = board->walls + (size_t)(row + 1) * board->stride + 1;
+        for (int col = 0; col < maze->width; col++, p_cell++)
+            if (*p_cell == BLOCKED) w[col >> 6] |= (uint64_t)1 << (col & 63);
+        if (maze->width & 63)
+            w[board->words - 1] |= ~(uint64_t)0 << (maze->width & 63);
+    }
+    return board;
+}
+
+void bitboard_free(bitboard_t *board)
+{
+    assert(board != NULL);
+    if (board->map != NULL)
+        munmap(board->map, board->map_size);
+    else
+        free(board->walls);
+    free(board);
+}
+
+static inline size_t bitboard_index(const bitboard_t *board, const int row, const int col)
+{
+    return (size_t)(row + 1) * board->stride + 1 + (col >> 6);
+}
+
+static void bitboard_record(bitboard_snapshots_t *s, const size_t index, const uint64_t bits)
+{
+    if (s->size == s->capacity)
+    {
+        s->capacity *= 2;
+        s->index = (uint32_t*)realloc(s->index, s->capacity * sizeof(uint32_t));
+        s->bits = (uint64_t*)realloc(s->bits, s->capacity * sizeof(uint64_t));
+        if (s->index == NULL || s->bits == NULL)
+        {
+            perror("Unable to grow level snapshots");
+            exit(EXIT_FAILURE);
+        }
+    }
+    s->index[s->size] = (uint32_t)index;
+    s->bits[s->size] = bits;
+    s->size++;
+}
+
+static void bitboard_level(bitboard_snapshots_t *s)
+{
+    if (s->levels + 2 > s->level_capacity)
+    {
+        s->level_capacity *= 2;
+        s->level = (size_t*)realloc(s->level, s->level_capacity * sizeof(size_t));
+        if (s->level == NULL)
+        {
+            perror("Unable to grow level snapshots");
+            exit(EXIT_FAILURE);
+        }
+    }
+    s->level[++s->levels] = s->size;
+}
+
+/* Next frontier of the words [lo, hi] of a row */
+static inline void bitboard_run(const uint64_t *f, uint64_t *n, uint64_t *v, const int stride,
+                                int lo, const int hi, const size_t base, bitboard_snapshots_t *s,
+                                long long *reached)
+{
+    for (int w = lo; w <= hi; w++)
+    {
+        uint64_t x = ((f[w] << 1) | (f[w - 1] >> 63) | (f[w] >> 1) | (f[w + 1] << 63)
+                      | f[w - stride] | f[w + stride]) & ~v[w];
+        n[w] = x;
+        if (x)
+        {
+            v[w] |= x;
+            bitboard_record(s, base + w, x);
+            *reached += __builtin_popcountll(x);
+        }
+    }
+}
+
+#ifdef BITBOARD_X86
+__attribute__((target("avx2,popcnt")))
+static void bitboard_run_avx2(const uint64_t *f, uint64_t *n, uint64_t *v, const int stride,
+                              int lo, const int hi, const size_t base, bitboard_snapshots_t *s,
+                              long long *reached)
+{
+    for (; lo + 3 <= hi; lo += 4)
+    {
+        __m256i c = _mm256_loadu_si256((const __m256i*)(f + lo));
+        __m256i l = _mm256_loadu_si256((const __m256i*)(f + lo - 1));
+        __m256i r = _mm256_loadu_si256((const __m256i*)(f + lo + 1));
+        __m256i u = _mm256_loadu_si256((const __m256i*)(f + lo - stride));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(f + lo + stride));
+        __m256i vv = _mm256_loadu_si256((const __m256i*)(v + lo));
+        __m256i x = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi64(c, 1), _mm256_srli_epi64(l, 63)),
+                                    _mm256_or_si256(_mm256_srli_epi64(c, 1), _mm256_slli_epi64(r, 63)));
+        x = _mm256_andnot_si256(vv, _mm256_or_si256(x, _mm256_or_si256(u, d)));
+        _mm256_storeu_si256((__m256i*)(n + lo), x);
+        if (!_mm256_testz_si256(x, x))
+        {
+            _mm256_storeu_si256((__m256i*)(v + lo), _mm256_or_si256(vv, x));
+            for (int k = 0; k < 4; k++)
+                if (n[lo + k])
+                {
+                    bitboard_record(s, base + lo + k, n[lo + k]);
+                    *reached += __builtin_popcountll(n[lo + k]);
+                }
+        }
+    }
+    bitboard_run(f, n, v, stride, lo, hi, base, s, reached);
+}
+#endif
+
+/* Evaluate the words [lo, hi] of the padded board, a run that may cross
+   rows; the padding is left alone. */
+static void bitboard_step_run(const bitboard_t *board, const uint64_t *front, uint64_t *next,
+                              uint64_t *visited, size_t lo, const size_t hi,
+                              bitboard_snapshots_t *s, long long *reached)
+{
+    const int stride = board->stride;
+    while (lo <= hi)
+    {
+        const size_t row = lo / stride, base = row * stride;
+        const size_t row_hi = (hi < base + stride - 1) ? hi : base + stride - 1;
+        if (row >= 1 && row <= (size_t)board->height)
+        {
+            int a = (int)(lo - base), b = (int)(row_hi - base);
+            if (a < 1) a = 1;
+            if (b > board->words) b = board->words;
+#ifdef BITBOARD_X86
+            if (bitboard_avx2 && b - a + 1 >= BITBOARD_WIDE)
+                bitboard_run_avx2(front + base, next + base, visited + base, stride, a, b, base, s, reached);
+            else
+#endif
+            if (a <= b)
+                bitboard_run(front + base, next + base, visited + base, stride, a, b, base, s, reached);
+        }
+        lo = base + stride;
+    }
+}
+
+/* One level: the frontier is level l of the snapshots, entries [begin, end)
+   sorted by index. The words that may change are the entries moved one row
+   up, one row down, and widened by a word on either side; merging the three
+   sorted streams gives them in order as runs of words, so evaluating the
+   runs appends level l + 1 to the snapshots sorted as well. */
+static void bitboard_step(const bitboard_t *board, const uint64_t *front, uint64_t *next, uint64_t *visited,
+                          const size_t begin, const size_t end, bitboard_snapshots_t *s,
+                          long long *reached)
+{
+    const size_t stride = board->stride;
+    size_t up = begin, at = begin, down = begin;
+    size_t lo = 1, hi = 0;
+    while (down < end)
+    {
+        /* The next interval by first word; the down stream ends last */
+        const size_t xu = (up < end) ? s->index[up] - stride : SIZE_MAX;
+        const size_t xa = (at < end) ? s->index[at] - 1 : SIZE_MAX;
+        const size_t xd = s->index[down] + stride;
+        size_t x, y;
+        if (xu <= xa && xu <= xd)
+        {
+            x = y = xu;
+            up++;
+        }
+        else if (xa <= xd)
+        {
+            x = xa;
+            y = xa + 2;
+            at++;
+        }
+        else
+        {
+            x = y = xd;
+            down++;
+        }
+        if (x <= hi + 1)
+        {
+            if (y > hi) hi = y;
+        }
+        else
+        {
+            if (hi >= lo) bitboard_step_run(board, front, next, visited, lo, hi, s, reached);
+            lo = x;
+            hi = y;
+        }
+    }
+    if (hi >= lo) bitboard_step_run(board, front, next, visited, lo, hi, s, reached);
+}
+
+/* Find the cell (row, col) of level l, 0-based, in the snapshots */
+static int bitboard_in_level(const bitboard_t *board, const bitboard_snapshots_t *s, const size_t l,
+                             const int row, const int col)
+{
+    if (row < 0 || col < 0 || row >= board->height || col >= board->width) return 0;
+    uint32_t index = (uint32_t)bitboard_index(board, row, col);
+    size_t lo = s->level[l], hi = s->level[l + 1];
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (s->index[mid] < index) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < s->level[l + 1] && s->index[lo] == index && ((s->bits[lo] >> (col & 63)) & 1);
+}
+
+/* Breadth-first search from source to target on the bitboard. Return the
+   distance (INT_MAX if target is unreachable); *path gets the path as
+   shortest_path builds it (from target to source, source at the front) and
+   *expanded the number of cells expanded, the frontiers of all the levels
+   searched, as parallelBFS counts them. */
+int bitboardBFS(const bitboard_t *board, const position_t source, const position_t target,
+                list_t **path, long long *expanded)
+{
+    const int stride = board->stride;
+    const size_t size = (size_t)(board->height + 2) * stride;
+    if (size > UINT32_MAX)
+    {
+        fprintf(stderr, "Bitboard of %zu words is too large\n", size);
+        exit(EXIT_FAILURE);
+    }
+    uint64_t *visited = (uint64_t*)malloc(size * sizeof(uint64_t));
+    uint64_t *front = (uint64_t*)calloc(size, sizeof(uint64_t));
+    uint64_t *next = (uint64_t*)calloc(size, sizeof(uint64_t));
+    bitboard_snapshots_t s = {NULL, NULL, 0, 1024, NULL, 0, 1024};
+    s.index = (uint32_t*)malloc(s.capacity * sizeof(uint32_t));
+    s.bits = (uint64_t*)malloc(s.capacity * sizeof(uint64_t));
+    s.level = (size_t*)malloc(s.level_capacity * sizeof(size_t));
+    if (visited == NULL || front == NULL || next == NULL || s.index == NULL || s.bits == NULL || s.level == NULL)
+    {
+        perror("Unable to allocate search state");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(visited, board->walls, size * sizeof(uint64_t));
+
+    size_t sw = bitboard_index(board, source.row, source.col);
+    uint64_t sbit = (uint64_t)1 << (source.col & 63);
+    size_t tw = bitboard_index(board, target.row, target.col);
+    uint64_t tbit = (uint64_t)1 << (target.col & 63);
+    front[sw] = sbit;
+    visited[sw] |= sbit;
+    s.level[0] = 0;
+    bitboard_record(&s, sw, sbit);
+    bitboard_level(&s);
+    *expanded = 0;
+
+    int distance = 0;
+    long long frontier = 1;
+    while (!(front[tw] & tbit))
+    {
+        size_t begin = s.level[distance], end = s.level[distance + 1];
+        if (begin == end)
+        {
+            distance = INT_MAX;
+            break;
+        }
+        long long reached = 0;
+        bitboard_step(board, front, next, visited, begin, end, &s, &reached);
+        bitboard_level(&s);
+        *expanded += frontier;
+        frontier = reached;
+        /* Clear the old frontier and swap */
+        for (size_t e = begin; e < end; e++) front[s.index[e]] = 0;
+        uint64_t *tmp = front; front = next; next = tmp;
+        distance++;
+    }
+
+    *path = NULL;
+    if (distance != INT_MAX)
+    {
+        /* Walk back from the target through the levels */
+        position_t p = target, q;
+        *path = list_add(p, NULL);
+        for (int l = distance - 1; l >= 0; l--)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                q.row = p.row + (i == 0) - (i == 1);
+                q.col = p.col + (i == 2) - (i == 3);
+                if (bitboard_in_level(board, &s, l, q.row, q.col)) break;
+            }
+            p = q;
+            *path = list_add(p, *path);
+        }
+    }
+    free(visited);
+    free(front);
+    free(next);
+    free(s.index);
+    free(s.bits);
+    free(s.level);
+    return distance;
+}
+
+#endif
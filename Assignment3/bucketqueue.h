@@ -0,0 +1,131 @@
+/* Bucketed priority queue for the open list of the A* searches of the maze */
+
+#ifndef __BUCKETQUEUE_H__
+#define __BUCKETQUEUE_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BUCKET_NONE UINT32_MAX
+
+/* One bucket per integer key, each a stack (last in, first out) of cells
+ * linked through a pool of entries. With a consistent heuristic the keys
+ * popped never decrease, so pop only scans forward from the current bucket,
+ * and entries popped go to a free list and are reused: the pool is as large
+ * as the largest open list and neither pushes nor pops call the allocator
+ * once it has grown.
+ */
+typedef struct bucketentry {
+    uint32_t cell;
+    uint32_t next;  /* next entry of the bucket or of the free list */
+} bucketentry_t;
+
+typedef struct bucketqueue {
+    bucketentry_t * entries;
+    size_t capacity, used;  /* entries allocated, entries ever handed out */
+    uint32_t free;          /* first entry of the free list */
+    uint32_t * head;        /* first entry of every bucket */
+    size_t buckets;
+    size_t current;         /* key of the last cell popped; no bucket below is occupied */
+    size_t size;            /* number of cells in the queue */
+} bucketqueue_t;
+
+/* Allocate a queue for keys below buckets and capacity cells; both grow on
+ * demand. Return false if out of memory. */
+bool bucketqueue_create(bucketqueue_t * queue, size_t capacity, size_t buckets){
+    if (capacity == 0) capacity = 1;
+    if (buckets == 0) buckets = 1;
+    queue->entries = (bucketentry_t*)malloc(capacity * sizeof(bucketentry_t));
+    queue->head = (uint32_t*)malloc(buckets * sizeof(uint32_t));
+    queue->capacity = capacity;
+    queue->used = 0;
+    queue->free = BUCKET_NONE;
+    queue->buckets = buckets;
+    queue->current = 0;
+    queue->size = 0;
+    if (queue->entries == NULL || queue->head == NULL){
+        perror("Unable to allocate bucket queue");
+        return false;
+    }
+    for (size_t b = 0; b < buckets; b++) queue->head[b] = BUCKET_NONE;
+    return true;
+}
+
+/* Free the buffers of a queue */
+void bucketqueue_free(bucketqueue_t * queue){
+    free(queue->entries);
+    free(queue->head);
+    queue->entries = NULL;
+    queue->head = NULL;
+    queue->size = 0;
+}
+
+/* Determine whether a queue is empty */
+bool bucketqueue_empty(const bucketqueue_t * queue){
+    return queue->size == 0;
+}
+
+/* Insert a cell with the given key, which must not be below the key of the
+ * last cell popped. Return false if out of memory. */
+bool bucketqueue_push(bucketqueue_t * queue, const size_t key, const uint32_t cell){
+#ifdef DEBUG
+    if (key < queue->current){
+        fprintf(stderr, "bucketqueue_push: key %zu below current bucket %zu\n", key, queue->current);
+        exit(EXIT_FAILURE);
+    }
+#endif
+    if (key >= queue->buckets){
+        size_t buckets = queue->buckets;
+        while (buckets <= key) buckets *= 2;
+        uint32_t *head = (uint32_t*)realloc(queue->head, buckets * sizeof(uint32_t));
+        if (head == NULL){
+            perror("Unable to grow bucket queue");
+            return false;
+        }
+        for (size_t b = queue->buckets; b < buckets; b++) head[b] = BUCKET_NONE;
+        queue->head = head;
+        queue->buckets = buckets;
+    }
+    uint32_t e = queue->free;
+    if (e != BUCKET_NONE){
+        queue->free = queue->entries[e].next;
+    }else{
+        if (queue->used == queue->capacity){
+            if (queue->capacity >= BUCKET_NONE / 2){
+                fprintf(stderr, "Error: bucket queue capacity exceeded\n");
+                return false;
+            }
+            bucketentry_t *entries = (bucketentry_t*)realloc(queue->entries,
+                                                             2 * queue->capacity * sizeof(bucketentry_t));
+            if (entries == NULL){
+                perror("Unable to grow bucket queue");
+                return false;
+            }
+            queue->entries = entries;
+            queue->capacity *= 2;
+        }
+        e = (uint32_t)queue->used++;
+    }
+    queue->entries[e].cell = cell;
+    queue->entries[e].next = queue->head[key];
+    queue->head[key] = e;
+    queue->size++;
+    return true;
+}
+
+/* Remove and return a cell of the lowest key of a non-empty queue, the one
+ * pushed last among them; its key is stored in *key. */
+uint32_t bucketqueue_pop(bucketqueue_t * queue, size_t * key){
+    while (queue->head[queue->current] == BUCKET_NONE) queue->current++;
+    uint32_t e = queue->head[queue->current];
+    queue->head[queue->current] = queue->entries[e].next;
+    queue->entries[e].next = queue->free;
+    queue->free = e;
+    queue->size--;
+    *key = queue->current;
+    return queue->entries[e].cell;
+}
+
+#endif
@@ -5,6 +5,10 @@
 
 #include "position.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 typedef /* Various states a maze cell may be in */
 enum cell {OPEN, BLOCKED, VISITED, PATH, START, END}
     cell_t;
@@ -46,6 +50,77 @@ void freeMaze(maze_t * maze)
     free(maze);
 }
 
+/* Classify one row of maze characters into cells: ' ' and '0' are open,
+   's'/'S' the start, 't'/'T' the end and anything else a wall. Sixteen
+   characters are compared at a time; the rare start and end characters are
+   picked out afterwards, left to right, so the last one of a row wins just
+   as when reading character by character. */
+void classifyRow(const char* chars, cell_t* cells, const int row, const int width,
+                 position_t* start, position_t* end)
+{
+    int col = 0;
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8(' '), zero = _mm_set1_epi8('0');
+    const __m128i lower = _mm_set1_epi8(0x20), s = _mm_set1_epi8('s'), t = _mm_set1_epi8('t');
+    const __m128i open = _mm_set1_epi8(OPEN), blocked = _mm_set1_epi8(BLOCKED), none = _mm_setzero_si128();
+    _Static_assert(sizeof(cell_t) == 4, "cells are widened to 32 bits");
+    for ( ; col + 16 <= width ; col += 16)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i*)(chars + col));
+        __m128i isOpen = _mm_or_si128(_mm_cmpeq_epi8(c, space), _mm_cmpeq_epi8(c, zero));
+        __m128i x = _mm_or_si128(_mm_and_si128(isOpen, open), _mm_andnot_si128(isOpen, blocked));
+        /* Widen the 16 cell bytes to cell_t */
+        __m128i lo = _mm_unpacklo_epi8(x, none), hi = _mm_unpackhi_epi8(x, none);
+        _mm_storeu_si128((__m128i*)(cells + col), _mm_unpacklo_epi16(lo, none));
+        _mm_storeu_si128((__m128i*)(cells + col + 4), _mm_unpackhi_epi16(lo, none));
+        _mm_storeu_si128((__m128i*)(cells + col + 8), _mm_unpacklo_epi16(hi, none));
+        _mm_storeu_si128((__m128i*)(cells + col + 12), _mm_unpackhi_epi16(hi, none));
+        /* 'S' | 0x20 == 's' and 'T' | 0x20 == 't', and no other character maps there */
+        __m128i folded = _mm_or_si128(c, lower);
+        int special = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(folded, s), _mm_cmpeq_epi8(folded, t)));
+        while (special)
+        {
+            int k = __builtin_ctz(special);
+            special &= special - 1;
+            if ((chars[col + k] | 0x20) == 's')
+            {
+                cells[col + k] = START;
+                start->row = row;
+                start->col = col + k;
+            }
+            else
+            {
+                cells[col + k] = END;
+                end->row = row;
+                end->col = col + k;
+            }
+        }
+    }
+#endif
+    for ( ; col < width ; col++)
+    {
+        switch(chars[col])
+        {
+        case 's': case 'S':
+            cells[col] = START;
+            start->row = row;
+            start->col = col;
+            break;
+        case 't': case 'T':
+            cells[col] = END;
+            end->row = row;
+            end->col = col;
+            break;
+        case ' ': case '0':
+            cells[col] = OPEN;
+            break;
+        default:
+            cells[col] = BLOCKED;
+            break;
+        } // switch
+    } // for col
+}
+
 /* Read a maze from the given file stream pointer. */
 maze_t* readMaze(FILE* stream)
 {
@@ -62,7 +137,7 @@ maze_t* readMaze(FILE* stream)
         return NULL;
         
     /* Create cell array of the appropriate size */
-    cell_t *p_cells = (cell_t*)malloc(height*width*sizeof(cell_t));
+    cell_t *p_cells = (cell_t*)malloc((size_t)height*width*sizeof(cell_t));
 
     if (p_cells==NULL)
     {
@@ -85,49 +160,38 @@ maze_t* readMaze(FILE* stream)
     maze->width = width;
     maze->cells = p_cells;
 
-    /* Loop over all cells, reading and storing data */
-    int row, col;
+    /* Row buffer */
+    char* line = (char*)malloc(width);
+
+    if (line==NULL)
+    {
+        perror("Unable to allocate line");
+        freeMaze(maze);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Loop over all rows, reading and storing data */
+    int row;
     cell_t* p_cell = p_cells;
-    char cellChar;
-    for (row=0 ; row<height; row++)
+    for (row=0 ; row<height; row++, p_cell+=width)
     {
-        for (col=0 ; col<width ; col++, p_cell++)
-        {
-        /* Read next character */
-        if ( fscanf(stream,"%c",&cellChar) != 1)
-        { /* Verify input read acceptably */
-            if (feof(stream))
-            fprintf(stderr,"Premature end of input while reading maze");
-            else if (ferror(stream))
-            perror("Error reading maze");
-            freeMaze(maze); /* Clean up before aborting */
-            return NULL;
-        }
-        else
-        switch(cellChar)
-        {
-        case 's': case 'S':
-            *p_cell = START;
-            start.row = row;
-            start.col = col;
-            maze->start = start;
-            break;
-        case 't': case 'T':
-            *p_cell = END;
-            end.row = row;
-            end.col = col;
-            maze->end = end;
-            break;
-        case ' ': case '0':
-            *p_cell = OPEN;
-            break;
-        default:
-            *p_cell = BLOCKED;
-            break;
-        } // switch
-    } // for col
+    /* Read the row */
+    if (fread(line, 1, width, stream) != (size_t)width)
+    { /* Verify input read acceptably */
+        if (feof(stream))
+        fprintf(stderr,"Premature end of input while reading maze");
+        else if (ferror(stream))
+        perror("Error reading maze");
+        free(line);
+        freeMaze(maze); /* Clean up before aborting */
+        return NULL;
+    }
+    classifyRow(line, p_cell, row, width, &start, &end);
+
     /* Read newline */
     int lineEnd = fgetc(stream);
+    if (lineEnd == '\r') /* Accept CRLF line ends */
+        lineEnd = fgetc(stream);
 
     if (lineEnd != '\n' && row!=height-1) /* Newline not required in last row */
     {
@@ -135,10 +199,14 @@ maze_t* readMaze(FILE* stream)
             fprintf(stderr,"Premature end of input while reading maze");
         else if (ferror(stream))
             perror("Error reading maze");
+        free(line);
         freeMaze(maze); /* Clean up before aborting */
         return NULL;
     }
     } // for row
+    free(line);
+    maze->start = start;
+    maze->end = end;
 
     if (start.row == -1)
     {
@@ -187,14 +255,15 @@ void printMaze(const maze_t* maze)
 }
       
 /* Get the offset for a position in the given maze */
-int offset(const maze_t* maze, position_t position)
+size_t offset(const maze_t* maze, position_t position)
 {
     assert( position.row >= 0);
     assert( position.col >= 0);
     assert( position.row < maze->height);
     assert( position.col < maze->width);
 
-    return maze->width * position.row  +  position.col;
+    // In size_t, as mazes may have up to UINT32_MAX cells
+    return (size_t)maze->width * position.row  +  position.col;
 }
 
 #endif
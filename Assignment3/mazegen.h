@@ -0,0 +1,136 @@
+/* Random maze generation, to have mazes of any size for measuring the solver */
+
+#ifndef __MAZEGEN_H__
+#define __MAZEGEN_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "maze.h"
+
+/* xorshift64* */
+static inline uint64_t maze_rand(uint64_t *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/* Generate a perfect maze (exactly one path between any two open cells) of
+   the given dimensions by a randomized depth-first search. Rooms are the
+   cells with odd row and column, walls the rest; the search runs on an
+   explicit stack, so the size is only limited by memory. The start is the
+   top left room and the end the bottom right one. Afterwards every inner
+   wall between two rooms is knocked down with probability open, which adds
+   loops: 0 keeps the perfect maze, 1 leaves a grid of pillars. */
+maze_t *generateMaze(const int height, const int width, const unsigned long long seed, const double open)
+{
+    if (!isValidMazeHeader(2, height, width))
+        return NULL;
+    if (height < 3 || width < 3)
+    {
+        fprintf(stderr, "Maze must be at least 3 x 3, received %d x %d\n", height, width);
+        return NULL;
+    }
+    maze_t *maze = (maze_t*)malloc(sizeof(maze_t));
+    cell_t *cells = (cell_t*)malloc((size_t)height * width * sizeof(cell_t));
+    const int rows = (height - 1) / 2, cols = (width - 1) / 2;
+    uint32_t *stack = (uint32_t*)malloc((size_t)rows * cols * sizeof(uint32_t));
+    if (maze == NULL || cells == NULL || stack == NULL)
+    {
+        perror("Unable to allocate maze");
+        exit(EXIT_FAILURE);
+    }
+    maze->height = height;
+    maze->width = width;
+    maze->cells = cells;
+    for (size_t i = 0; i < (size_t)height * width; i++) cells[i] = BLOCKED;
+
+    /* Room r (row-major among rows x cols) is the cell (2 (r / cols) + 1, 2 (r % cols) + 1) */
+    uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    size_t top = 0;
+    stack[top++] = 0;
+    cells[(size_t)width + 1] = OPEN;
+    while (top > 0)
+    {
+        uint32_t r = stack[top - 1];
+        int row = r / cols, col = r % cols;
+        int next[4], count = 0;
+        if (row > 0 && cells[(size_t)(2 * row - 1) * width + 2 * col + 1] == BLOCKED) next[count++] = r - cols;
+        if (row < rows - 1 && cells[(size_t)(2 * row + 3) * width + 2 * col + 1] == BLOCKED) next[count++] = r + cols;
+        if (col > 0 && cells[(size_t)(2 * row + 1) * width + 2 * col - 1] == BLOCKED) next[count++] = r - 1;
+        if (col < cols - 1 && cells[(size_t)(2 * row + 1) * width + 2 * col + 3] == BLOCKED) next[count++] = r + 1;
+        if (count == 0)
+        {
+            top--;
+            continue;
+        }
+        uint32_t s = next[maze_rand(&state) % count];
+        int srow = s / cols, scol = s % cols;
+        /* Open the wall between the rooms and the new room */
+        cells[(size_t)(row + srow + 1) * width + col + scol + 1] = OPEN;
+        cells[(size_t)(2 * srow + 1) * width + 2 * scol + 1] = OPEN;
+        stack[top++] = s;
+    }
+    free(stack);
+
+    if (open > 0)
+    {
+        const uint64_t threshold = (open >= 1) ? UINT64_MAX : (uint64_t)(open * 18446744073709551616.0);
+        for (int row = 1; row < 2 * rows; row++)
+            for (int col = 1 + (row & 1); col < 2 * cols; col += 2)
+                if (maze_rand(&state) <= threshold)
+                    cells[(size_t)row * width + col] = OPEN;
+    }
+
+    maze->start.row = 1;
+    maze->start.col = 1;
+    maze->end.row = 2 * rows - 1;
+    maze->end.col = 2 * cols - 1;
+    cells[offset(maze, maze->start)] = START;
+    cells[offset(maze, maze->end)] = END;
+    return maze;
+}
+
+/* Write a maze in the format read by readMaze, exiting on a write error. */
+void writeMaze(FILE *stream, const maze_t *maze)
+{
+    assert(stream != NULL && maze != NULL);
+    char *line = (char*)malloc(maze->width + 1);
+    if (line == NULL)
+    {
+        perror("Unable to allocate line");
+        exit(EXIT_FAILURE);
+    }
+    if (fprintf(stream, "%d %d\n", maze->height, maze->width) < 0)
+    {
+        perror("Error writing maze");
+        exit(EXIT_FAILURE);
+    }
+    const cell_t *p_cell = maze->cells;
+    for (int row = 0; row < maze->height; row++)
+    {
+        for (int col = 0; col < maze->width; col++, p_cell++)
+        {
+            switch (*p_cell)
+            {
+            case START:   line[col] = 's'; break;
+            case END:     line[col] = 't'; break;
+            case BLOCKED: line[col] = '*'; break;
+            default:      line[col] = ' '; break;
+            }
+        }
+        line[maze->width] = '\n';
+        if (fwrite(line, 1, maze->width + 1, stream) != (size_t)maze->width + 1)
+        {
+            perror("Error writing maze");
+            exit(EXIT_FAILURE);
+        }
+    }
+    free(line);
+}
+
+#endif
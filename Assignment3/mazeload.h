@@ -0,0 +1,351 @@
+/* Loading mazes from memory-mapped files, in the text format of readMaze or
+   in a compact binary format */
+
+#ifndef __MAZELOAD_H__
+#define __MAZELOAD_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <limits.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "maze.h"
+#include "bitboard.h"
+
+/* Binary maze format: a 32-byte header followed by the walls of the maze in
+   the layout of bitboard_t, (height + 2) * (words + 2) uint64 words of one
+   bit per cell with the padding, in the byte order of the machine. A file is
+   an eighth of the size of the text one and its walls map straight into a
+   bitboard without being copied. */
+#define MAZE_BINARY_MAGIC "MAZEBIT1"
+
+typedef struct {
+    char magic[8];
+    int32_t height, width;
+    int32_t start_row, start_col;
+    int32_t end_row, end_col;
+} maze_binary_header_t;
+
+typedef struct {
+    const char *data;
+    size_t size;
+} maze_map_t;
+
+/* Map a whole file read-only. Return 0 if it cannot be mapped (an empty
+   file, a pipe), after closing it; errno tells why. */
+static int maze_map(const char *file, maze_map_t *map)
+{
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+    {
+        close(fd);
+        return 0;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return 0;
+    map->data = (const char*)data;
+    map->size = st.st_size;
+    return 1;
+}
+
+static int maze_is_binary(const maze_map_t *map)
+{
+    return map->size >= sizeof(maze_binary_header_t)
+        && memcmp(map->data, MAZE_BINARY_MAGIC, 8) == 0;
+}
+
+/* Validate a binary maze file: its header against its size, and its padding
+   and start and end cells against what bitboard_create writes (zero pad rows
+   and pad words, the bits past the last column set, start and end open), so
+   that a bitboard mapped from it searches the maze the header describes. */
+static int maze_binary_valid(const maze_map_t *map)
+{
+    const maze_binary_header_t *header = (const maze_binary_header_t*)map->data;
+    if (!isValidMazeHeader(2, header->height, header->width))
+        return 0;
+    const size_t words = ((size_t)header->width + 63) / 64, stride = words + 2;
+    size_t expected = sizeof(maze_binary_header_t) + ((size_t)header->height + 2) * stride * sizeof(uint64_t);
+    if (map->size != expected)
+    {
+        fprintf(stderr, "Binary maze of %d x %d must be %zu bytes, received %zu\n",
+                header->height, header->width, expected, map->size);
+        return 0;
+    }
+    if (header->start_row < 0 || header->start_row >= header->height
+        || header->start_col < 0 || header->start_col >= header->width)
+    {
+        fprintf(stderr, "Error in maze input: No start position denoted");
+        return 0;
+    }
+    if (header->end_row < 0 || header->end_row >= header->height
+        || header->end_col < 0 || header->end_col >= header->width)
+    {
+        fprintf(stderr, "Error in maze input: No end position denoted");
+        return 0;
+    }
+
+    const uint64_t *walls = (const uint64_t*)(map->data + sizeof(maze_binary_header_t));
+    const uint64_t tail = (header->width & 63) ? ~(uint64_t)0 << (header->width & 63) : 0;
+    for (size_t w = 0; w < stride; w++)
+        if (walls[w] != 0 || walls[((size_t)header->height + 1) * stride + w] != 0)
+        {
+            fprintf(stderr, "Binary maze has a corrupt pad row\n");
+            return 0;
+        }
+    for (int row = 0; row < header->height; row++)
+    {
+        const uint64_t *w = walls + (size_t)(row + 1) * stride;
+        if (w[0] != 0 || w[stride - 1] != 0 || (w[words] & tail) != tail)
+        {
+            fprintf(stderr, "Binary maze has corrupt padding in row %d\n", row);
+            return 0;
+        }
+    }
+    const uint64_t *s = walls + (size_t)(header->start_row + 1) * stride + 1 + (header->start_col >> 6);
+    const uint64_t *t = walls + (size_t)(header->end_row + 1) * stride + 1 + (header->end_col >> 6);
+    if (((*s >> (header->start_col & 63)) & 1) || ((*t >> (header->end_col & 63)) & 1))
+    {
+        fprintf(stderr, "Binary maze has its start or end cell marked as a wall\n");
+        return 0;
+    }
+    return 1;
+}
+
+static maze_t *maze_new(const int height, const int width)
+{
+    cell_t *p_cells = (cell_t*)malloc((size_t)height * width * sizeof(cell_t));
+    if (p_cells == NULL)
+    {
+        perror("Unable to allocate cell array");
+        exit(EXIT_FAILURE);
+    }
+    maze_t *maze = (maze_t*)malloc(sizeof(maze_t));
+    if (maze == NULL)
+    {
+        perror("Unable to allocate maze structure");
+        free(p_cells);
+        exit(EXIT_FAILURE);
+    }
+    maze->height = height;
+    maze->width = width;
+    maze->cells = p_cells;
+    return maze;
+}
+
+/* Expand the walls of a binary maze into cells */
+static maze_t *maze_from_binary(const maze_map_t *map)
+{
+    const maze_binary_header_t *header = (const maze_binary_header_t*)map->data;
+    if (!maze_binary_valid(map))
+        return NULL;
+    maze_t *maze = maze_new(header->height, header->width);
+    const int stride = (header->width + 63) / 64 + 2;
+    const uint64_t *walls = (const uint64_t*)(map->data + sizeof(maze_binary_header_t));
+    /* The cells of every 4 bits, copied 4 cells at a time */
+    cell_t nibble[16][4];
+    for (int n = 0; n < 16; n++)
+        for (int b = 0; b < 4; b++)
+            nibble[n][b] = ((n >> b) & 1) ? BLOCKED : OPEN;
+    cell_t *p_cell = maze->cells;
+    for (int row = 0; row < maze->height; row++)
+    {
+        const uint64_t *w = walls + (size_t)(row + 1) * stride + 1;
+        int col = 0;
+        for ( ; col + 4 <= maze->width; col += 4, p_cell += 4)
+            memcpy(p_cell, nibble[(w[col >> 6] >> (col & 63)) & 15], sizeof(nibble[0]));
+        for ( ; col < maze->width; col++, p_cell++)
+            *p_cell = ((w[col >> 6] >> (col & 63)) & 1) ? BLOCKED : OPEN;
+    }
+    maze->start.row = header->start_row;
+    maze->start.col = header->start_col;
+    maze->end.row = header->end_row;
+    maze->end.col = header->end_col;
+    maze->cells[offset(maze, maze->start)] = START;
+    maze->cells[offset(maze, maze->end)] = END;
+    return maze;
+}
+
+/* Read a header integer as fscanf's "%d" does, after skipping white space.
+   Return 0 on a matching failure and -1 at the end of the input. */
+static int maze_scan_int(const maze_map_t *map, size_t *pos, int *value)
+{
+    while (*pos < map->size && isspace((unsigned char)map->data[*pos])) (*pos)++;
+    if (*pos == map->size) return -1;
+    size_t p = *pos;
+    int negative = 0;
+    if (map->data[p] == '-' || map->data[p] == '+') negative = (map->data[p++] == '-');
+    if (p == map->size || !isdigit((unsigned char)map->data[p])) return 0;
+    long long x = 0;
+    while (p < map->size && isdigit((unsigned char)map->data[p]))
+    {
+        if (x <= INT_MAX) x = 10 * x + (map->data[p] - '0');
+        p++;
+    }
+    if (x > INT_MAX) x = INT_MAX;
+    *value = (int)(negative ? -x : x);
+    *pos = p;
+    return 1;
+}
+
+/* Parse a maze in the text format of readMaze, with the same validation and
+   messages, classifying every row in place with classifyRow. */
+static maze_t *maze_from_text(const maze_map_t *map)
+{
+    int height, width;
+    position_t start = {-1, -1};
+    position_t end = {-1, -1};
+
+    /* The header, as fscanf(stream, "%d %d ", ...) */
+    size_t pos = 0;
+    int numTokens = maze_scan_int(map, &pos, &height);
+    if (numTokens == 1)
+        numTokens += maze_scan_int(map, &pos, &width) == 1;
+    if (!isValidMazeHeader(numTokens, height, width))
+        return NULL;
+    while (pos < map->size && isspace((unsigned char)map->data[pos])) pos++;
+
+    maze_t *maze = maze_new(height, width);
+    cell_t *p_cell = maze->cells;
+    for (int row = 0; row < height; row++, p_cell += width)
+    {
+        if (map->size - pos < (size_t)width)
+        {
+            fprintf(stderr, "Premature end of input while reading maze");
+            freeMaze(maze);
+            return NULL;
+        }
+        classifyRow(map->data + pos, p_cell, row, width, &start, &end);
+        pos += width;
+
+        /* Newline, not required in the last row */
+        if (row == height - 1) break;
+        int lineEnd = (pos < map->size) ? (unsigned char)map->data[pos++] : EOF;
+        if (lineEnd == '\r') /* Accept CRLF line ends */
+            lineEnd = (pos < map->size) ? (unsigned char)map->data[pos++] : EOF;
+        if (lineEnd != '\n')
+        {
+            if (lineEnd == EOF)
+                fprintf(stderr, "Premature end of input while reading maze");
+            freeMaze(maze);
+            return NULL;
+        }
+    }
+    maze->start = start;
+    maze->end = end;
+
+    if (start.row == -1)
+    {
+        fprintf(stderr, "Error in maze input: No start position denoted");
+        freeMaze(maze);
+        return NULL;
+    }
+    if (end.row == -1)
+    {
+        fprintf(stderr, "Error in maze input: No end position denoted");
+        freeMaze(maze);
+        return NULL;
+    }
+    return maze;
+}
+
+/* Load a maze from a file, text or binary. The file is memory-mapped;
+   files that cannot be mapped are read with readMaze instead. */
+maze_t *loadMaze(const char *file)
+{
+    assert(file != NULL);
+    maze_map_t map;
+    if (!maze_map(file, &map))
+    {
+        FILE *fp = fopen(file, "r");
+        if (fp == NULL)
+        {
+            perror("Unable to open maze file");
+            return NULL;
+        }
+        maze_t *maze = readMaze(fp);
+        fclose(fp);
+        return maze;
+    }
+    maze_t *maze;
+    if (maze_is_binary(&map))
+    {
+        maze = maze_from_binary(&map);
+    }
+    else
+    {
+        madvise((void*)map.data, map.size, MADV_SEQUENTIAL);
+        maze = maze_from_text(&map);
+    }
+    munmap((void*)map.data, map.size);
+    return maze;
+}
+
+/* Map the walls of a binary maze file as a bitboard, without copying them;
+   the file is validated by maze_binary_valid first. Return NULL if it is not
+   a valid binary maze. */
+bitboard_t *mapBitboard(const char *file)
+{
+    assert(file != NULL);
+    maze_map_t map;
+    if (!maze_map(file, &map))
+        return NULL;
+    if (!maze_is_binary(&map) || !maze_binary_valid(&map))
+    {
+        munmap((void*)map.data, map.size);
+        return NULL;
+    }
+    bitboard_t *board = (bitboard_t*)malloc(sizeof(bitboard_t));
+    if (board == NULL)
+    {
+        perror("Unable to allocate bitboard");
+        munmap((void*)map.data, map.size);
+        return NULL;
+    }
+    const maze_binary_header_t *header = (const maze_binary_header_t*)map.data;
+    board->height = header->height;
+    board->width = header->width;
+    board->words = (header->width + 63) / 64;
+    board->stride = board->words + 2;
+    board->walls = (uint64_t*)(map.data + sizeof(maze_binary_header_t));
+    board->map = (void*)map.data;
+    board->map_size = map.size;
+    return board;
+}
+
+/* Write a maze in the binary format read by loadMaze. */
+void writeMazeBinary(FILE *stream, const maze_t *maze)
+{
+    assert(stream != NULL && maze != NULL);
+    bitboard_t *board = bitboard_create(maze);
+    if (board == NULL)
+        exit(EXIT_FAILURE);
+    maze_binary_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAZE_BINARY_MAGIC, 8);
+    header.height = maze->height;
+    header.width = maze->width;
+    header.start_row = maze->start.row;
+    header.start_col = maze->start.col;
+    header.end_row = maze->end.row;
+    header.end_col = maze->end.col;
+    size_t words = (size_t)(board->height + 2) * board->stride;
+    if (fwrite(&header, sizeof(header), 1, stream) != 1
+        || fwrite(board->walls, sizeof(uint64_t), words, stream) != words)
+    {
+        perror("Error writing maze");
+        exit(EXIT_FAILURE);
+    }
+    bitboard_free(board);
+}
+
+#endif
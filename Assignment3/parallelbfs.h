@@ -0,0 +1,418 @@
+/* Multithreaded breadth-first search of the maze from T, level by level.
+
+   Every level is one parallel step over the frontier, in one of two ways
+   (direction-optimizing BFS, after Beamer, Asanovic and Patterson):
+
+   top-down (push)
+   The frontier is an array of cells, handed out to the threads in chunks.
+   Each thread claims the unvisited neighbors with an atomic OR on the
+   visited bitmap, writes their distance and collects them in a local queue
+   that is flushed in blocks to the next frontier array.
+
+   bottom-up (pull)
+   The frontier is a bitmap. Each thread takes whole words of the visited
+   bitmap and checks every unvisited cell in them for a neighbor in the
+   frontier. A thread only writes the words it owns, so nothing is atomic.
+
+   Walls are marked visited up front, so the unvisited bits are the open
+   cells still to reach. A top-down step costs the edges of the frontier, a
+   bottom-up step the unvisited cells plus one test per bitmap word. The
+   search switches to bottom-up when the edges of the frontier exceed 1/ALPHA
+   of the latter, and back once they drop below 1/BETA of it. (Beamer's n/BETA
+   test uses all vertices; on a grid the frontier is only about the square
+   root of the open cells, so the same measure is used both ways.) As with opt = 0 it
+   stops after the level that reaches S, and it fills distance (INT_MAX for
+   unreached cells, which is INFTY) the way mazeBFS does. */
+
+#ifndef __PARALLELBFS_H__
+#define __PARALLELBFS_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "maze.h"
+
+#ifndef PBFS_ALPHA
+#define PBFS_ALPHA 14
+#endif
+#ifndef PBFS_BETA
+#define PBFS_BETA 24
+#endif
+#define PBFS_CHUNK 1024     /* frontier cells or bitmap words taken at a time */
+#define PBFS_LOCAL 4096     /* cells a thread collects before flushing them */
+#ifndef PBFS_SERIAL
+#define PBFS_SERIAL 4096    /* smaller top-down levels are run on one thread */
+#endif
+
+enum pbfs_phase {PBFS_TOPDOWN, PBFS_BOTTOMUP, PBFS_CLEAR, PBFS_TOBITMAP, PBFS_TOQUEUE, PBFS_DONE};
+
+typedef struct {
+    const maze_t *maze;
+    int *distance;
+    size_t cells, words;
+    int threads;
+    pthread_barrier_t barrier;
+
+    uint64_t *visited;
+    uint64_t *front, *next_front;   /* frontier bitmaps (bottom-up) */
+    uint32_t *cur, *next;           /* frontier arrays (top-down) */
+    size_t cur_size, next_size;
+    size_t index;                   /* next chunk to hand out */
+    size_t next_count;              /* cells reached by a bottom-up step */
+    size_t open, unvisited;
+    int level, found, bottomup;
+    int phase, pending[3], npending;
+    size_t frontier;                /* cells of the level being expanded */
+    long long expanded;
+    struct pbfs_thread *serial;     /* thread 0, for the levels run alone */
+} pbfs_t;
+
+typedef struct pbfs_thread {
+    pbfs_t *ctx;
+    int id;
+    uint32_t local[PBFS_LOCAL];
+    size_t size;
+} pbfs_thread_t;
+
+static void pbfs_flush(pbfs_thread_t *t)
+{
+    pbfs_t *ctx = t->ctx;
+    if (t->size == 0) return;
+    size_t at = __atomic_fetch_add(&ctx->next_size, t->size, __ATOMIC_RELAXED);
+    memcpy(ctx->next + at, t->local, t->size * sizeof(uint32_t));
+    t->size = 0;
+}
+
+static inline void pbfs_push(pbfs_thread_t *t, const uint32_t cell)
+{
+    t->local[t->size++] = cell;
+    if (t->size == PBFS_LOCAL) pbfs_flush(t);
+}
+
+/* Words [lo, hi) of the bitmaps for thread id of a static partition */
+static inline void pbfs_range(const pbfs_t *ctx, const int id, size_t *lo, size_t *hi)
+{
+    *lo = ctx->words * id / ctx->threads;
+    *hi = ctx->words * (id + 1) / ctx->threads;
+}
+
+/* Reset distance and mark the walls (and the bits past the last cell) visited */
+static void pbfs_initialize(pbfs_t *ctx, const int id)
+{
+    const cell_t *cells = ctx->maze->cells;
+    size_t lo, hi, open = 0;
+    pbfs_range(ctx, id, &lo, &hi);
+    for (size_t w = lo; w < hi; w++)
+    {
+        uint64_t walls = 0;
+        for (size_t b = 0; b < 64; b++)
+        {
+            size_t c = w * 64 + b;
+            if (c >= ctx->cells) walls |= (uint64_t)1 << b;
+            else
+            {
+                ctx->distance[c] = INT_MAX;
+                if (cells[c] == BLOCKED) walls |= (uint64_t)1 << b;
+            }
+        }
+        ctx->visited[w] = walls;
+        open += 64 - __builtin_popcountll(walls);
+    }
+    __atomic_fetch_add(&ctx->open, open, __ATOMIC_RELAXED);
+}
+
+static void pbfs_topdown(pbfs_thread_t *t)
+{
+    pbfs_t *ctx = t->ctx;
+    const int width = ctx->maze->width, height = ctx->maze->height, d = ctx->level + 1;
+    const uint32_t start = offset(ctx->maze, ctx->maze->start);
+    size_t i;
+    while ((i = __atomic_fetch_add(&ctx->index, PBFS_CHUNK, __ATOMIC_RELAXED)) < ctx->cur_size)
+    {
+        size_t end = (i + PBFS_CHUNK < ctx->cur_size) ? i + PBFS_CHUNK : ctx->cur_size;
+        for (; i < end; i++)
+        {
+            uint32_t c = ctx->cur[i];
+            int row = c / width, col = c - row * width;
+            uint32_t adjacent[4];
+            int n = 0;
+            if (row > 0) adjacent[n++] = c - width;
+            if (row < height - 1) adjacent[n++] = c + width;
+            if (col > 0) adjacent[n++] = c - 1;
+            if (col < width - 1) adjacent[n++] = c + 1;
+            for (int k = 0; k < n; k++)
+            {
+                uint32_t a = adjacent[k];
+                uint64_t bit = (uint64_t)1 << (a & 63);
+                if (ctx->visited[a >> 6] & bit) continue;
+                if (__atomic_fetch_or(&ctx->visited[a >> 6], bit, __ATOMIC_RELAXED) & bit) continue;
+                ctx->distance[a] = d;
+                if (a == start) __atomic_store_n(&ctx->found, 1, __ATOMIC_RELAXED);
+                pbfs_push(t, a);
+            }
+        }
+    }
+    pbfs_flush(t);
+}
+
+static void pbfs_bottomup(pbfs_thread_t *t)
+{
+    pbfs_t *ctx = t->ctx;
+    const int width = ctx->maze->width, height = ctx->maze->height, d = ctx->level + 1;
+    const uint32_t start = offset(ctx->maze, ctx->maze->start);
+    const uint64_t *front = ctx->front;
+    size_t w, reached = 0;
+    while ((w = __atomic_fetch_add(&ctx->index, PBFS_CHUNK, __ATOMIC_RELAXED)) < ctx->words)
+    {
+        size_t end = (w + PBFS_CHUNK < ctx->words) ? w + PBFS_CHUNK : ctx->words;
+        for (; w < end; w++)
+        {
+            uint64_t found = 0;
+            for (uint64_t bits = ~ctx->visited[w]; bits; bits &= bits - 1)
+            {
+                uint32_t c = w * 64 + __builtin_ctzll(bits);
+                int row = c / width, col = c - row * width;
+                if ((row > 0 && ((front[(c - width) >> 6] >> ((c - width) & 63)) & 1))
+                    || (row < height - 1 && ((front[(c + width) >> 6] >> ((c + width) & 63)) & 1))
+                    || (col > 0 && ((front[(c - 1) >> 6] >> ((c - 1) & 63)) & 1))
+                    || (col < width - 1 && ((front[(c + 1) >> 6] >> ((c + 1) & 63)) & 1)))
+                {
+                    found |= bits & -bits;
+                    ctx->distance[c] = d;
+                    if (c == start) __atomic_store_n(&ctx->found, 1, __ATOMIC_RELAXED);
+                }
+            }
+            ctx->visited[w] |= found;
+            ctx->next_front[w] = found;
+            reached += __builtin_popcountll(found);
+        }
+    }
+    __atomic_fetch_add(&ctx->next_count, reached, __ATOMIC_RELAXED);
+}
+
+static void pbfs_run(pbfs_thread_t *t)
+{
+    pbfs_t *ctx = t->ctx;
+    size_t lo, hi, i;
+    switch (ctx->phase)
+    {
+    case PBFS_TOPDOWN:
+        pbfs_topdown(t);
+        break;
+    case PBFS_BOTTOMUP:
+        pbfs_bottomup(t);
+        break;
+    case PBFS_CLEAR:
+        pbfs_range(ctx, t->id, &lo, &hi);
+        memset(ctx->front + lo, 0, (hi - lo) * sizeof(uint64_t));
+        break;
+    case PBFS_TOBITMAP:
+        while ((i = __atomic_fetch_add(&ctx->index, PBFS_CHUNK, __ATOMIC_RELAXED)) < ctx->cur_size)
+            for (size_t end = (i + PBFS_CHUNK < ctx->cur_size) ? i + PBFS_CHUNK : ctx->cur_size; i < end; i++)
+                __atomic_fetch_or(&ctx->front[ctx->cur[i] >> 6], (uint64_t)1 << (ctx->cur[i] & 63),
+                                  __ATOMIC_RELAXED);
+        break;
+    case PBFS_TOQUEUE:
+        pbfs_range(ctx, t->id, &lo, &hi);
+        for (size_t w = lo; w < hi; w++)
+            for (uint64_t bits = ctx->front[w]; bits; bits &= bits - 1)
+                pbfs_push(t, w * 64 + __builtin_ctzll(bits));
+        pbfs_flush(t);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Account for the level just finished and pick the step for the next one */
+static void pbfs_next_level(pbfs_t *ctx)
+{
+    size_t nf = ctx->bottomup ? ctx->next_count : ctx->next_size;
+    ctx->expanded += ctx->frontier;
+    ctx->frontier = nf;
+    ctx->unvisited -= nf;
+    ctx->level++;
+    if (ctx->found || nf == 0)
+    {
+        ctx->phase = PBFS_DONE;
+        return;
+    }
+    if (!ctx->bottomup)
+    {
+        uint32_t *tmp = ctx->cur; ctx->cur = ctx->next; ctx->next = tmp;
+        ctx->cur_size = nf;
+        ctx->next_size = 0;
+        if (4 * nf > (ctx->unvisited + ctx->words) / PBFS_ALPHA)
+        {
+            ctx->bottomup = 1;
+            ctx->phase = PBFS_CLEAR;
+            ctx->pending[0] = PBFS_TOBITMAP;
+            ctx->pending[1] = PBFS_BOTTOMUP;
+            ctx->npending = 2;
+            ctx->next_count = 0;
+        }
+        else
+        {
+            ctx->phase = PBFS_TOPDOWN;
+        }
+    }
+    else
+    {
+        uint64_t *tmp = ctx->front; ctx->front = ctx->next_front; ctx->next_front = tmp;
+        ctx->next_count = 0;
+        if (4 * nf < (ctx->unvisited + ctx->words) / PBFS_BETA)
+        {
+            /* TOQUEUE fills next from front, TOPDOWN then swaps it into cur */
+            ctx->bottomup = 0;
+            ctx->phase = PBFS_TOQUEUE;
+            ctx->next_size = 0;
+            ctx->pending[0] = PBFS_TOPDOWN;
+            ctx->npending = 1;
+        }
+        else
+        {
+            ctx->phase = PBFS_BOTTOMUP;
+        }
+    }
+}
+
+/* Between two steps, on thread 0 while the others wait: pick the next step.
+   Top-down levels too small to be worth sharing are run right here, so a
+   long thin search (a perfect maze has a handful of cells per level) does
+   not pay two barriers per level. */
+static void pbfs_schedule(pbfs_t *ctx)
+{
+    ctx->index = 0;
+    if (ctx->npending > 0)
+    {
+        ctx->phase = ctx->pending[0];
+        for (int i = 1; i < ctx->npending; i++) ctx->pending[i - 1] = ctx->pending[i];
+        ctx->npending--;
+        if (ctx->phase == PBFS_TOPDOWN)
+        {
+            /* the frontier converted by PBFS_TOQUEUE becomes cur */
+            uint32_t *tmp = ctx->cur; ctx->cur = ctx->next; ctx->next = tmp;
+            ctx->cur_size = ctx->next_size;
+            ctx->next_size = 0;
+        }
+    }
+    else if (ctx->phase != PBFS_TOPDOWN && ctx->phase != PBFS_BOTTOMUP)
+    {
+        /* first step: the frontier is T alone */
+        ctx->phase = PBFS_TOPDOWN;
+    }
+    else
+    {
+        pbfs_next_level(ctx);
+    }
+    while (ctx->phase == PBFS_TOPDOWN && ctx->cur_size < PBFS_SERIAL)
+    {
+        pbfs_topdown(ctx->serial);
+        ctx->index = 0;
+        pbfs_next_level(ctx);
+    }
+}
+
+static void *pbfs_worker(void *arg)
+{
+    pbfs_thread_t *t = (pbfs_thread_t*)arg;
+    pbfs_t *ctx = t->ctx;
+    pbfs_initialize(ctx, t->id);
+    while (1)
+    {
+        pthread_barrier_wait(&ctx->barrier);
+        pthread_barrier_wait(&ctx->barrier);   /* thread 0 schedules in between */
+        if (ctx->phase == PBFS_DONE) break;
+        pbfs_run(t);
+    }
+    return NULL;
+}
+
+/* Search the maze from T on the given number of threads (0 for one per
+   online processor). Return the number of cells expanded, the frontiers of
+   all the levels run, to compare with the cells mazeBFS dequeues. */
+long long parallelBFS(const maze_t *maze, int *distance, int threads)
+{
+    if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    pbfs_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.maze = maze;
+    ctx.distance = distance;
+    ctx.cells = (size_t)maze->height * maze->width;
+    ctx.words = (ctx.cells + 63) / 64;
+    ctx.threads = threads;
+    ctx.phase = PBFS_DONE;
+    ctx.visited = (uint64_t*)malloc(ctx.words * sizeof(uint64_t));
+    ctx.front = (uint64_t*)malloc(ctx.words * sizeof(uint64_t));
+    ctx.next_front = (uint64_t*)malloc(ctx.words * sizeof(uint64_t));
+    /* A top-down step runs on at most (unvisited / ALPHA) / 4 cells and so
+       yields at most unvisited / ALPHA, and a bitmap frontier only turns back
+       into an array below open / BETA cells: cells / 8 is always enough. */
+    ctx.cur = (uint32_t*)malloc((ctx.cells / 8 + 64) * sizeof(uint32_t));
+    ctx.next = (uint32_t*)malloc((ctx.cells / 8 + 64) * sizeof(uint32_t));
+    pthread_t *tid = (pthread_t*)malloc(threads * sizeof(pthread_t));
+    pbfs_thread_t *t = (pbfs_thread_t*)malloc(threads * sizeof(pbfs_thread_t));
+    if (ctx.visited == NULL || ctx.front == NULL || ctx.next_front == NULL || ctx.cur == NULL
+        || ctx.next == NULL || tid == NULL || t == NULL)
+    {
+        perror("Unable to allocate search state");
+        exit(EXIT_FAILURE);
+    }
+    pthread_barrier_init(&ctx.barrier, NULL, threads);
+
+    uint32_t end = offset(maze, maze->end);
+    ctx.serial = &t[0];
+    for (int i = 0; i < threads; i++)
+    {
+        t[i].ctx = &ctx;
+        t[i].id = i;
+        t[i].size = 0;
+    }
+    for (int i = 1; i < threads; i++)
+        if (pthread_create(&tid[i], NULL, pbfs_worker, &t[i]) != 0)
+        {
+            perror("Unable to create thread");
+            exit(EXIT_FAILURE);
+        }
+    pbfs_initialize(&ctx, 0);
+    pthread_barrier_wait(&ctx.barrier);
+    /* The source goes in after every thread has reset its part of the maze */
+    distance[end] = 0;
+    ctx.visited[end >> 6] |= (uint64_t)1 << (end & 63);
+    ctx.cur[0] = end;
+    ctx.cur_size = 1;
+    ctx.unvisited = ctx.open - 1;
+    ctx.frontier = 1;
+    pbfs_schedule(&ctx);
+    pthread_barrier_wait(&ctx.barrier);
+    if (ctx.phase != PBFS_DONE)
+    {
+        pbfs_run(&t[0]);
+        while (1)
+        {
+            pthread_barrier_wait(&ctx.barrier);
+            pbfs_schedule(&ctx);
+            pthread_barrier_wait(&ctx.barrier);
+            if (ctx.phase == PBFS_DONE) break;
+            pbfs_run(&t[0]);
+        }
+    }
+    for (int i = 1; i < threads; i++) pthread_join(tid[i], NULL);
+    pthread_barrier_destroy(&ctx.barrier);
+    free(ctx.visited);
+    free(ctx.front);
+    free(ctx.next_front);
+    free(ctx.cur);
+    free(ctx.next);
+    free(tid);
+    free(t);
+    return ctx.expanded;
+}
+
+#endif
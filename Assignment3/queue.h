@@ -1,83 +1,82 @@
-/* Queue data structure for storing partial solutions to the maze problem */
+/* Queue data structure for storing the cells still to be expanded by the
+   breadth-first search of the maze */
 
 #ifndef __QUEUE_H__
 #define __QUEUE_H__
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
-#include "path.h"
+#include <stdint.h>
 
-/* List-backed Queue consists of nodes, each of which has a reference to a
- * solution (path), as well as the next node inthe queue.
+/* Ring buffer of packed cell offsets (width*row + col), allocated once for
+ * the whole search. A search enqueues every cell at most once, so a capacity
+ * of height*width cells never overflows; a smaller one wraps around and only
+ * has to hold the largest frontier.
  */
-typedef struct node {
-    list_t * solution;
-    struct node * next;
-} node_t;
-
-/* Queue structure contains references to the front and rear nodes for easy
- * insertion at the end and deletion from the front */
 typedef struct queue {
-    node_t * head;
-    node_t * tail;
+    uint32_t * cells;
+    size_t capacity;
+    size_t head;    /* index of the front cell */
+    size_t size;    /* number of cells in the queue */
 } queue_t;
 
-/* Initialize a queue data structure */
-void queue_initialize(queue_t * queue){
-    while (queue->head)
-    {
-        node_t *temp = queue->head;
-        queue->head = queue->head->next;
-        free(temp);
+/* Allocate a queue for capacity cells. Return false if out of memory. */
+bool queue_create(queue_t * queue, const size_t capacity){
+    queue->cells = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->size = 0;
+    if (queue->cells == NULL){
+        perror("Unable to allocate queue");
+        return false;
     }
-    queue->tail = NULL;
+    return true;
+}
+
+/* Free the buffer of a queue */
+void queue_free(queue_t * queue){
+    free(queue->cells);
+    queue->cells = NULL;
+    queue->capacity = 0;
+    queue->size = 0;
+}
+
+/* Initialize (empty) a queue data structure */
+void queue_initialize(queue_t * queue){
+    queue->head = 0;
+    queue->size = 0;
 }
 
 /* Determine whether a queue is empty */
 bool queue_empty (const queue_t * queue){
-    return queue->head == NULL;
+    return queue->size == 0;
 }
 
-/* Insert a solution at the end of a queue */
-bool enqueue (queue_t * queue, list_t* path){
-    node_t *newnode = (node_t*)malloc(sizeof(node_t));
-    list_t *solution = (list_t*)malloc(sizeof(list_t));
-    solution->position = path->position;
-    if (newnode == NULL){
-        fprintf(stderr, "Error: unable to allocate required memory\n");
+/* Insert a cell at the end of a queue. Return false if it is full. */
+static inline bool enqueue (queue_t * queue, const uint32_t cell){
+    if (queue->size == queue->capacity){
+        fprintf(stderr, "Error: queue capacity %zu exceeded\n", queue->capacity);
         return false;
     }
-    newnode->solution = solution;
-    newnode->next = NULL;
-    if(queue_empty(queue)){
-        queue->head = newnode;
-    }else{
-        queue->tail->next = newnode;
-    }
-    queue->tail = newnode;
+    size_t tail = queue->head + queue->size;
+    if (tail >= queue->capacity) tail -= queue->capacity;
+    queue->cells[tail] = cell;
+    queue->size++;
     return true;
 }
 
-/* Remove and return the item at the front of the queue */
-list_t * dequeue (queue_t * queue){
-    //check if the queue is empty
-    if(!queue->head)
-        return NULL;
-    list_t * result = (list_t*)malloc(sizeof(list_t));
-    result->position.col = queue->head->solution->position.col;
-    result->position.row = queue->head->solution->position.row;
-    result->next = NULL;
-    node_t *temp = queue->head;
-    queue->head = queue->head->next;
-    if(!queue->head){
-        queue->tail = NULL;
-    }
-    free(temp);
-    return result;
+/* Remove and return the cell at the front of a non-empty queue */
+static inline uint32_t dequeue (queue_t * queue){
+    uint32_t cell = queue->cells[queue->head];
+    if (++queue->head == queue->capacity) queue->head = 0;
+    queue->size--;
+    return cell;
 }
 
-/* Return the solution at the front of the queue */
-list_t* queue_front (const queue_t * queue){
-    return queue->head->solution;
+/* Return the cell at the front of a non-empty queue */
+uint32_t queue_front (const queue_t * queue){
+    return queue->cells[queue->head];
 }
 
 #endif